@@ -0,0 +1,129 @@
+#include "InputScanner.h"
+#include "arduino.h"
+
+// Find the port that a pin is on, adding it to the ports we scan if necessary, and get the bit mask for the pin.
+// Returns the port index, or -1 if we are already scanning the maximum number of ports.
+int8_t InputScanner::addPin(int pin, uint8_t& mask)
+{
+  volatile uint8_t * const reg = portInputRegister(digitalPinToPort(pin));
+  mask = digitalPinToBitMask(pin);
+  for (uint8_t i = 0; i < numPorts; ++i)
+  {
+    if (ports[i].pinReg == reg)
+    {
+      return i;
+    }
+  }
+  if (numPorts == MaxPorts)
+  {
+    return -1;
+  }
+  Port& p = ports[numPorts];
+  p.pinReg = reg;
+  p.buttonMask = 0;
+  p.lastInputs = *reg;
+  p.pressed = 0;
+  p.count0 = p.count1 = 0;
+  return numPorts++;
+}
+
+bool InputScanner::addButton(PushButton& b)
+{
+  uint8_t mask;
+  const int8_t port = addPin(b.getPin(), mask);
+  if (port < 0 || numButtons == MaxButtons)
+  {
+    return false;
+  }
+  Port& p = ports[port];
+  p.buttonMask |= mask;
+  
+  // Buttons are active low. Start with the current state, so that a button held down at startup doesn't count as a new press.
+  if ((*p.pinReg & mask) == 0)
+  {
+    p.pressed |= mask;
+  }
+  b.setState((p.pressed & mask) != 0);
+  b.getNewPress();
+  
+  Button& bt = buttons[numButtons++];
+  bt.button = &b;
+  bt.port = port;
+  bt.mask = mask;
+  return true;
+}
+
+bool InputScanner::addEncoder(RotaryEncoder& e)
+{
+  uint8_t mask0, mask1;
+  const int8_t port0 = addPin(e.getPin0(), mask0);
+  const int8_t port1 = addPin(e.getPin1(), mask1);
+  if (port0 < 0 || port1 < 0 || numEncoders == MaxEncoders)
+  {
+    return false;
+  }
+  Encoder& en = encoders[numEncoders++];
+  en.encoder = &e;
+  en.port0 = port0;
+  en.port1 = port1;
+  en.mask0 = mask0;
+  en.mask1 = mask1;
+  return true;
+}
+
+void InputScanner::scan()
+{
+  uint8_t portsChanged = 0;                     // bit n set if the inputs on port n have changed since the last scan
+  uint8_t buttonsChanged = 0;                   // bit n set if the debounced state of a button on port n has changed
+  uint8_t toggled[MaxPorts];
+  for (uint8_t i = 0; i < numPorts; ++i)
+  {
+    Port& p = ports[i];
+    const uint8_t inputs = *p.pinReg;
+    if (inputs != p.lastInputs)
+    {
+      p.lastInputs = inputs;
+      portsChanged |= (1u << i);
+    }
+
+    // Count the scans for which each button has read differently from its debounced state. The count is reset when the button reads the same again.
+    // When the count wraps round after 4 scans, toggle the debounced state.
+    const uint8_t different = (uint8_t)(~inputs ^ p.pressed) & p.buttonMask;
+    const uint8_t c0 = p.count0;
+    p.count0 = ~c0 & different;
+    p.count1 = (p.count1 ^ c0) & different;
+    const uint8_t t = different & ~(p.count0 | p.count1);
+    p.pressed ^= t;
+    toggled[i] = t;
+    if (t != 0)
+    {
+      buttonsChanged |= (1u << i);
+    }
+  }
+
+  if (buttonsChanged != 0)
+  {
+    for (uint8_t i = 0; i < numButtons; ++i)
+    {
+      const Button& bt = buttons[i];
+      if (toggled[bt.port] & bt.mask)
+      {
+        bt.button->setState((ports[bt.port].pressed & bt.mask) != 0);
+      }
+    }
+  }
+
+  if (portsChanged != 0)
+  {
+    for (uint8_t i = 0; i < numEncoders; ++i)
+    {
+      const Encoder& en = encoders[i];
+      if (portsChanged & ((1u << en.port0) | (1u << en.port1)))
+      {
+        en.encoder->update(((ports[en.port0].lastInputs & en.mask0) ? 1u : 0u) | ((ports[en.port1].lastInputs & en.mask1) ? 2u : 0u));
+      }
+    }
+  }
+}
+
+// End
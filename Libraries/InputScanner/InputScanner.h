@@ -0,0 +1,63 @@
+#ifndef __InputScanner_Included
+#define __InputScanner_Included
+
+#include <stdint.h>
+#include <PushButton.h>
+#include <RotaryEncoder.h>
+
+// Class to poll a set of push buttons and rotary encoders together.
+// Each call to scan() reads the input register of each port that has inputs on it once, instead of calling digitalRead() for each pin.
+// The buttons are debounced in parallel using a 2-bit vertical counter per port, so a button must read the same for 4 scans in a row
+// before its state changes. The encoder pins are not debounced, because the encoder's state table already copes with contact bounce.
+// The cost of a scan depends on the number of ports used, not the number of inputs, except when a button or encoder changes state.
+class InputScanner
+{
+public:
+  static const uint8_t MaxPorts = 3;
+  static const uint8_t MaxButtons = 4;
+  static const uint8_t MaxEncoders = 2;
+
+  InputScanner() : numPorts(0), numButtons(0), numEncoders(0) {}
+
+  // Add a button or an encoder. Call its init() function first to set up the pins. Returns false if there is no room.
+  bool addButton(PushButton& b);
+  bool addEncoder(RotaryEncoder& e);
+
+  // Read the inputs and update the buttons and encoders. Call this every 1 to 5ms.
+  void scan();
+
+private:
+  struct Port
+  {
+    volatile uint8_t *pinReg;           // the input register
+    uint8_t buttonMask;                 // the bits that have buttons on them
+    uint8_t lastInputs;                 // the inputs when we last scanned
+    uint8_t pressed;                    // debounced button states, 1 = pressed
+    uint8_t count0, count1;             // vertical counter, counting how many scans each button has read differently from its debounced state
+  };
+
+  struct Button
+  {
+    PushButton *button;
+    uint8_t port;
+    uint8_t mask;
+  };
+
+  struct Encoder
+  {
+    RotaryEncoder *encoder;
+    uint8_t port0, port1;
+    uint8_t mask0, mask1;
+  };
+
+  int8_t addPin(int pin, uint8_t& mask);
+
+  Port ports[MaxPorts];
+  Button buttons[MaxButtons];
+  Encoder encoders[MaxEncoders];
+  uint8_t numPorts, numButtons, numEncoders;
+};
+
+#endif
+
+// End
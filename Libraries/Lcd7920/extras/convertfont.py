@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+# Convert a font table generated by MikroElektronika GLCD Font Creator (as used in glcd10x10.cpp and glcd16x16.cpp)
+# into the packed row-major format understood by Lcd7920::write().
+#
+# Usage: convertfont.py input.cpp output.cpp [suffix]
+#
+# The input file must contain the column-major font table followed by its LcdFont descriptor, as in glcd10x10.cpp.
+# The output file defines a font with the same name as the input font plus the suffix (default "Packed").
+#
+# Packed format: the index table holds the offset of each character within the font data.
+# Each character comprises one byte holding the active width in pixels, followed by one row of pixels for each pixel row of the font.
+# Each row is (width + 7)/8 bytes long, with the leftmost pixel in the most significant bit of the first byte.
+# This matches the layout of the display memory, and characters only occupy as much flash as their active width needs.
+
+import re
+import sys
+
+def parseFont(text):
+    text = re.sub(r'//[^\n]*', '', text)
+    m = re.search(r'\[\]\s*PROGMEM\s*=\s*\{(.*?)\}\s*;', text, re.S)
+    if m is None:
+        m = re.search(r'\[\]\s*=\s*\{(.*?)\}\s*;', text, re.S)
+    if m is None:
+        sys.exit("font table not found")
+    data = [int(v, 16) for v in re.findall(r'0x[0-9A-Fa-f]+', m.group(1))]
+    m = re.search(r'LcdFont\s+(\w+)\s*=\s*\{(.*?)\}\s*;', text, re.S)
+    if m is None:
+        sys.exit("font descriptor not found")
+    fields = [f.strip() for f in m.group(2).split(',') if f.strip() != '']
+    return (m.group(1), data, int(fields[1], 0), int(fields[2], 0), int(fields[3], 0), int(fields[4], 0), int(fields[5], 0))
+
+def charName(code):
+    if code == 0x5C:
+        return 'BackSlash'
+    return chr(code) if 0x20 <= code < 0x7F else '0x%02X' % code
+
+def convert(name, data, startChar, endChar, height, width, numSpaces, suffix):
+    bytesPerColumn = (height + 7)//8
+    bytesPerChar = bytesPerColumn * width + 1
+    numChars = endChar - startChar + 1
+    if len(data) != bytesPerChar * numChars:
+        sys.exit("font table has %d bytes, expected %d" % (len(data), bytesPerChar * numChars))
+    glyphs = []
+    for ch in range(numChars):
+        base = ch * bytesPerChar
+        activeWidth = data[base]
+        columns = []
+        for col in range(activeWidth):
+            colData = 0
+            for b in range(bytesPerColumn):
+                colData |= data[base + 1 + col * bytesPerColumn + b] << (8 * b)
+            columns.append(colData)
+        bytesPerRow = (activeWidth + 7)//8
+        glyph = [activeWidth]
+        for row in range(height):
+            rowBits = 0
+            for col in range(activeWidth):
+                if (columns[col] >> row) & 1:
+                    rowBits |= 1 << (8 * bytesPerRow - 1 - col)
+            glyph += [(rowBits >> (8 * (bytesPerRow - 1 - b))) & 0xFF for b in range(bytesPerRow)]
+        glyphs.append(glyph)
+    return glyphs
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit("Usage: convertfont.py input.cpp output.cpp [suffix]")
+    suffix = sys.argv[3] if len(sys.argv) > 3 else "Packed"
+    with open(sys.argv[1]) as f:
+        name, data, startChar, endChar, height, width, numSpaces = parseFont(f.read())
+    glyphs = convert(name, data, startChar, endChar, height, width, numSpaces, suffix)
+    tableName = "glcd" + name[4:] + suffix if name.startswith("font") else name + suffix + "Data"
+    fontName = name + suffix
+    out = []
+    out.append('#include "lcd7920.h"')
+    out.append('')
+    out.append('// Font generated by convertfont.py from %s (%d bytes)' % (sys.argv[1].replace('\\', '/').split('/')[-1], len(data)))
+    out.append('// Packed row-major format, %d bytes plus %d bytes of index' % (sum(len(g) for g in glyphs), 2 * len(glyphs)))
+    out.append('')
+    out.append('static const uint8_t %s[] PROGMEM =' % tableName)
+    out.append('{')
+    offsets = []
+    offset = 0
+    for ch, glyph in enumerate(glyphs):
+        offsets.append(offset)
+        offset += len(glyph)
+        out.append('\t' + ' '.join('0x%02X,' % b for b in glyph) + '  // Code for char ' + charName(startChar + ch))
+    out.append('};')
+    out.append('')
+    out.append('static const uint16_t %sIndex[] PROGMEM =' % tableName)
+    out.append('{')
+    for i in range(0, len(offsets), 16):
+        out.append('\t' + ' '.join('%d,' % o for o in offsets[i:i + 16]))
+    out.append('};')
+    out.append('')
+    out.append('extern const PROGMEM LcdFont %s =' % fontName)
+    out.append('{')
+    out.append('\t%s,\t\t// font data' % tableName)
+    out.append('\t0x%04X,\t\t\t// first character code' % startChar)
+    out.append('\t0x%04X,\t\t\t// last character code' % endChar)
+    out.append('\t%d,\t\t\t\t// row height in pixels' % height)
+    out.append('\t%d,\t\t\t\t// max character width in pixels' % width)
+    out.append('\t%d,\t\t\t\t// number of space pixels between characters before kerning' % numSpaces)
+    out.append('\t%sIndex\t// character offsets, so this font is in packed format' % tableName)
+    out.append('};')
+    out.append('')
+    out.append('')
+    out.append('// End')
+    out.append('')
+    with open(sys.argv[2], 'w', newline='\r\n' if '\r\n' in open(sys.argv[1], newline='').read() else '\n') as f:
+        f.write('\n'.join(out))
+
+if __name__ == '__main__':
+    main()
@@ -114,7 +114,8 @@ extern const PROGMEM LcdFont font10x10 =
 	0x007F,			// last character code
 	10,				// row height in pixels
 	10,				// character width in pixels
-	1				// number of space pixels between characters
+	1,				// number of space pixels between characters
+	nullptr			// column-major format, no index
 };
 
 
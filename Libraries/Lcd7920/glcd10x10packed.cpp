@@ -0,0 +1,128 @@
+#include "lcd7920.h"
+
+// Font generated by convertfont.py from glcd10x10.cpp (2016 bytes)
+// Packed row-major format, 1096 bytes plus 192 bytes of index
+
+static const uint8_t glcd10x10Packed[] PROGMEM =
+{
+	0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char  
+	0x01, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x80, 0x00, 0x00,  // Code for char !
+	0x03, 0xA0, 0xA0, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char "
+	0x05, 0x50, 0x50, 0xF8, 0x50, 0x50, 0xF8, 0x50, 0x50, 0x00, 0x00,  // Code for char #
+	0x05, 0x70, 0xA8, 0xA0, 0x70, 0x28, 0x28, 0xA8, 0x70, 0x20, 0x00,  // Code for char $
+	0x09, 0x62, 0x00, 0x94, 0x00, 0x94, 0x00, 0x68, 0x00, 0x0B, 0x00, 0x14, 0x80, 0x14, 0x80, 0x23, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char %
+	0x06, 0x30, 0x48, 0x48, 0x30, 0x50, 0x8C, 0x88, 0x74, 0x00, 0x00,  // Code for char &
+	0x01, 0x80, 0x80, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char '
+	0x03, 0x20, 0x40, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x40, 0x20,  // Code for char (
+	0x03, 0x80, 0x40, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x40, 0x80,  // Code for char )
+	0x05, 0xA8, 0x70, 0xF8, 0x70, 0xA8, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char *
+	0x05, 0x00, 0x00, 0x20, 0x20, 0xF8, 0x20, 0x20, 0x00, 0x00, 0x00,  // Code for char +
+	0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x40, 0x40,  // Code for char ,
+	0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE0, 0x00, 0x00, 0x00, 0x00,  // Code for char -
+	0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00,  // Code for char .
+	0x03, 0x20, 0x20, 0x40, 0x40, 0x40, 0x40, 0x80, 0x80, 0x00, 0x00,  // Code for char /
+	0x05, 0x70, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x70, 0x00, 0x00,  // Code for char 0
+	0x03, 0x20, 0x60, 0xA0, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00,  // Code for char 1
+	0x05, 0x70, 0x88, 0x08, 0x08, 0x10, 0x20, 0x40, 0xF8, 0x00, 0x00,  // Code for char 2
+	0x05, 0x70, 0x88, 0x08, 0x30, 0x08, 0x08, 0x88, 0x70, 0x00, 0x00,  // Code for char 3
+	0x06, 0x08, 0x18, 0x28, 0x48, 0x88, 0xFC, 0x08, 0x08, 0x00, 0x00,  // Code for char 4
+	0x05, 0xF8, 0x80, 0x80, 0xF0, 0x08, 0x08, 0x88, 0x70, 0x00, 0x00,  // Code for char 5
+	0x05, 0x70, 0x88, 0x80, 0xF0, 0x88, 0x88, 0x88, 0x70, 0x00, 0x00,  // Code for char 6
+	0x05, 0xF8, 0x10, 0x10, 0x20, 0x20, 0x40, 0x40, 0x40, 0x00, 0x00,  // Code for char 7
+	0x05, 0x70, 0x88, 0x88, 0x70, 0x88, 0x88, 0x88, 0x70, 0x00, 0x00,  // Code for char 8
+	0x05, 0x70, 0x88, 0x88, 0x88, 0x78, 0x08, 0x88, 0x70, 0x00, 0x00,  // Code for char 9
+	0x01, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00,  // Code for char :
+	0x01, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x80, 0x80, 0x80,  // Code for char ;
+	0x05, 0x00, 0x00, 0x08, 0x30, 0xC0, 0x30, 0x08, 0x00, 0x00, 0x00,  // Code for char <
+	0x05, 0x00, 0x00, 0x00, 0xF8, 0x00, 0xF8, 0x00, 0x00, 0x00, 0x00,  // Code for char =
+	0x05, 0x00, 0x00, 0x80, 0x60, 0x18, 0x60, 0x80, 0x00, 0x00, 0x00,  // Code for char >
+	0x05, 0x70, 0x88, 0x08, 0x10, 0x20, 0x20, 0x00, 0x20, 0x00, 0x00,  // Code for char ?
+	0x0A, 0x1F, 0x00, 0x20, 0x80, 0x4D, 0x40, 0x93, 0x40, 0xA2, 0x40, 0xA2, 0x40, 0xA6, 0x80, 0x9B, 0x00, 0x40, 0x40, 0x3F, 0x80,  // Code for char @
+	0x07, 0x10, 0x10, 0x28, 0x28, 0x44, 0x7C, 0x82, 0x82, 0x00, 0x00,  // Code for char A
+	0x06, 0xF8, 0x84, 0x84, 0xFC, 0x84, 0x84, 0x84, 0xF8, 0x00, 0x00,  // Code for char B
+	0x06, 0x38, 0x44, 0x80, 0x80, 0x80, 0x80, 0x44, 0x38, 0x00, 0x00,  // Code for char C
+	0x06, 0xF0, 0x88, 0x84, 0x84, 0x84, 0x84, 0x88, 0xF0, 0x00, 0x00,  // Code for char D
+	0x05, 0xF8, 0x80, 0x80, 0xF8, 0x80, 0x80, 0x80, 0xF8, 0x00, 0x00,  // Code for char E
+	0x05, 0xF8, 0x80, 0x80, 0xF0, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00,  // Code for char F
+	0x07, 0x38, 0x44, 0x82, 0x80, 0x8E, 0x82, 0x44, 0x38, 0x00, 0x00,  // Code for char G
+	0x06, 0x84, 0x84, 0x84, 0xFC, 0x84, 0x84, 0x84, 0x84, 0x00, 0x00,  // Code for char H
+	0x01, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00,  // Code for char I
+	0x04, 0x10, 0x10, 0x10, 0x10, 0x10, 0x90, 0x90, 0x60, 0x00, 0x00,  // Code for char J
+	0x06, 0x84, 0x88, 0x90, 0xB0, 0xD0, 0x88, 0x88, 0x84, 0x00, 0x00,  // Code for char K
+	0x05, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0xF8, 0x00, 0x00,  // Code for char L
+	0x07, 0x82, 0xC6, 0xC6, 0xAA, 0xAA, 0x92, 0x92, 0x82, 0x00, 0x00,  // Code for char M
+	0x06, 0x84, 0xC4, 0xA4, 0xA4, 0x94, 0x94, 0x8C, 0x84, 0x00, 0x00,  // Code for char N
+	0x07, 0x38, 0x44, 0x82, 0x82, 0x82, 0x82, 0x44, 0x38, 0x00, 0x00,  // Code for char O
+	0x05, 0xF0, 0x88, 0x88, 0x88, 0xF0, 0x80, 0x80, 0x80, 0x00, 0x00,  // Code for char P
+	0x07, 0x38, 0x44, 0x82, 0x82, 0x82, 0x9A, 0x44, 0x3A, 0x00, 0x00,  // Code for char Q
+	0x06, 0xF8, 0x84, 0x84, 0xF8, 0x90, 0x88, 0x88, 0x84, 0x00, 0x00,  // Code for char R
+	0x06, 0x78, 0x84, 0x80, 0x60, 0x18, 0x04, 0x84, 0x78, 0x00, 0x00,  // Code for char S
+	0x05, 0xF8, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00,  // Code for char T
+	0x06, 0x84, 0x84, 0x84, 0x84, 0x84, 0x84, 0x84, 0x78, 0x00, 0x00,  // Code for char U
+	0x07, 0x82, 0x82, 0x44, 0x44, 0x28, 0x28, 0x10, 0x10, 0x00, 0x00,  // Code for char V
+	0x0A, 0x80, 0x40, 0x80, 0x40, 0x4C, 0x80, 0x4C, 0x80, 0x52, 0x80, 0x52, 0x80, 0x21, 0x00, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char W
+	0x06, 0x84, 0x48, 0x48, 0x30, 0x30, 0x48, 0x48, 0x84, 0x00, 0x00,  // Code for char X
+	0x07, 0x82, 0x44, 0x44, 0x28, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00,  // Code for char Y
+	0x06, 0xFC, 0x08, 0x10, 0x10, 0x20, 0x20, 0x40, 0xFC, 0x00, 0x00,  // Code for char Z
+	0x02, 0xC0, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0xC0,  // Code for char [
+	0x03, 0x80, 0x80, 0x40, 0x40, 0x40, 0x40, 0x20, 0x20, 0x00, 0x00,  // Code for char BackSlash
+	0x02, 0xC0, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0xC0,  // Code for char ]
+	0x05, 0x20, 0x50, 0x50, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char ^
+	0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFC,  // Code for char _
+	0x02, 0x80, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char `
+	0x05, 0x00, 0x00, 0x70, 0x88, 0x78, 0x88, 0x98, 0x68, 0x00, 0x00,  // Code for char a
+	0x05, 0x80, 0x80, 0xB0, 0xC8, 0x88, 0x88, 0xC8, 0xB0, 0x00, 0x00,  // Code for char b
+	0x05, 0x00, 0x00, 0x70, 0x88, 0x80, 0x80, 0x88, 0x70, 0x00, 0x00,  // Code for char c
+	0x05, 0x08, 0x08, 0x68, 0x98, 0x88, 0x88, 0x98, 0x68, 0x00, 0x00,  // Code for char d
+	0x05, 0x00, 0x00, 0x70, 0x88, 0xF8, 0x80, 0x88, 0x70, 0x00, 0x00,  // Code for char e
+	0x03, 0x20, 0x40, 0xE0, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00,  // Code for char f
+	0x05, 0x00, 0x00, 0x68, 0x98, 0x88, 0x88, 0x98, 0x68, 0x08, 0xF0,  // Code for char g
+	0x05, 0x80, 0x80, 0xB0, 0xC8, 0x88, 0x88, 0x88, 0x88, 0x00, 0x00,  // Code for char h
+	0x01, 0x80, 0x00, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00,  // Code for char i
+	0x02, 0x40, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x80,  // Code for char j
+	0x04, 0x80, 0x80, 0x90, 0xA0, 0xC0, 0xA0, 0xA0, 0x90, 0x00, 0x00,  // Code for char k
+	0x01, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00,  // Code for char l
+	0x07, 0x00, 0x00, 0xBC, 0xD2, 0x92, 0x92, 0x92, 0x92, 0x00, 0x00,  // Code for char m
+	0x05, 0x00, 0x00, 0xF0, 0x88, 0x88, 0x88, 0x88, 0x88, 0x00, 0x00,  // Code for char n
+	0x05, 0x00, 0x00, 0x70, 0x88, 0x88, 0x88, 0x88, 0x70, 0x00, 0x00,  // Code for char o
+	0x05, 0x00, 0x00, 0xB0, 0xC8, 0x88, 0x88, 0xC8, 0xB0, 0x80, 0x80,  // Code for char p
+	0x05, 0x00, 0x00, 0x68, 0x98, 0x88, 0x88, 0x98, 0x68, 0x08, 0x08,  // Code for char q
+	0x03, 0x00, 0x00, 0xA0, 0xC0, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00,  // Code for char r
+	0x05, 0x00, 0x00, 0x70, 0x88, 0x60, 0x10, 0x88, 0x70, 0x00, 0x00,  // Code for char s
+	0x02, 0x80, 0x80, 0xC0, 0x80, 0x80, 0x80, 0x80, 0xC0, 0x00, 0x00,  // Code for char t
+	0x05, 0x00, 0x00, 0x88, 0x88, 0x88, 0x88, 0x98, 0x68, 0x00, 0x00,  // Code for char u
+	0x05, 0x00, 0x00, 0x88, 0x88, 0x50, 0x50, 0x20, 0x20, 0x00, 0x00,  // Code for char v
+	0x09, 0x00, 0x00, 0x00, 0x00, 0x80, 0x80, 0x88, 0x80, 0x55, 0x00, 0x55, 0x00, 0x22, 0x00, 0x22, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char w
+	0x05, 0x00, 0x00, 0x88, 0x50, 0x20, 0x20, 0x50, 0x88, 0x00, 0x00,  // Code for char x
+	0x05, 0x00, 0x00, 0x88, 0x88, 0x50, 0x50, 0x20, 0x20, 0x20, 0x40,  // Code for char y
+	0x05, 0x00, 0x00, 0xF8, 0x10, 0x20, 0x20, 0x40, 0xF8, 0x00, 0x00,  // Code for char z
+	0x03, 0x20, 0x40, 0x40, 0x40, 0x80, 0x40, 0x40, 0x40, 0x40, 0x20,  // Code for char {
+	0x01, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,  // Code for char |
+	0x04, 0x40, 0x20, 0x20, 0x20, 0x10, 0x20, 0x20, 0x20, 0x20, 0x40,  // Code for char }
+	0x05, 0x00, 0x00, 0x00, 0x68, 0xB0, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char ~
+	0x03, 0xE0, 0xA0, 0xA0, 0xA0, 0xA0, 0xA0, 0xA0, 0xE0, 0x00, 0x00,  // Code for char 0x7F
+};
+
+static const uint16_t glcd10x10PackedIndex[] PROGMEM =
+{
+	0, 11, 22, 33, 44, 55, 76, 87, 98, 109, 120, 131, 142, 153, 164, 175,
+	186, 197, 208, 219, 230, 241, 252, 263, 274, 285, 296, 307, 318, 329, 340, 351,
+	362, 383, 394, 405, 416, 427, 438, 449, 460, 471, 482, 493, 504, 515, 526, 537,
+	548, 559, 570, 581, 592, 603, 614, 625, 646, 657, 668, 679, 690, 701, 712, 723,
+	734, 745, 756, 767, 778, 789, 800, 811, 822, 833, 844, 855, 866, 877, 888, 899,
+	910, 921, 932, 943, 954, 965, 976, 987, 1008, 1019, 1030, 1041, 1052, 1063, 1074, 1085,
+};
+
+extern const PROGMEM LcdFont font10x10Packed =
+{
+	glcd10x10Packed,		// font data
+	0x0020,			// first character code
+	0x007F,			// last character code
+	10,				// row height in pixels
+	10,				// max character width in pixels
+	1,				// number of space pixels between characters before kerning
+	glcd10x10PackedIndex	// character offsets, so this font is in packed format
+};
+
+
+// End
@@ -113,7 +113,8 @@ extern const PROGMEM LcdFont font16x16 =
 	0x007F,				// last character code
 	16,					// row height in pixels
 	16,					// character width in pixels
-	1					// number of space pixels between characters before kerning
+	1,					// number of space pixels between characters before kerning
+	nullptr				// column-major format, no index
 };
 
 
@@ -0,0 +1,128 @@
+#include "lcd7920.h"
+
+// Font generated by convertfont.py from glcd16x16.cpp (3168 bytes)
+// Packed row-major format, 2128 bytes plus 192 bytes of index
+
+static const uint8_t glcd16x16Packed[] PROGMEM =
+{
+	0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char  
+	0x03, 0x00, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x20, 0x00, 0x00, 0x00,  // Code for char !
+	0x05, 0x00, 0x48, 0x48, 0x48, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char "
+	0x09, 0x00, 0x00, 0x11, 0x00, 0x11, 0x00, 0x11, 0x00, 0x22, 0x00, 0xFF, 0x80, 0x22, 0x00, 0x22, 0x00, 0x22, 0x00, 0xFF, 0x80, 0x44, 0x00, 0x44, 0x00, 0x44, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char #
+	0x08, 0x08, 0x1E, 0x29, 0x49, 0x48, 0x48, 0x38, 0x0E, 0x09, 0x09, 0x49, 0x2A, 0x1C, 0x08, 0x00, 0x00,  // Code for char $
+	0x0D, 0x00, 0x00, 0x38, 0x40, 0x44, 0x80, 0x44, 0x80, 0x45, 0x00, 0x45, 0x00, 0x39, 0x00, 0x02, 0x70, 0x02, 0x88, 0x04, 0x88, 0x04, 0x88, 0x08, 0x88, 0x08, 0x70, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char %
+	0x0A, 0x00, 0x00, 0x1C, 0x00, 0x22, 0x00, 0x22, 0x00, 0x22, 0x00, 0x14, 0x00, 0x18, 0x00, 0x28, 0x00, 0x44, 0x40, 0x42, 0x80, 0x41, 0x00, 0x22, 0x80, 0x1C, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char &
+	0x02, 0x00, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char '
+	0x04, 0x00, 0x10, 0x20, 0x20, 0x20, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x20, 0x20, 0x20, 0x10,  // Code for char (
+	0x04, 0x00, 0x40, 0x20, 0x20, 0x20, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x20, 0x20, 0x20, 0x40,  // Code for char )
+	0x05, 0x00, 0x20, 0xF8, 0x20, 0x50, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char *
+	0x08, 0x00, 0x00, 0x00, 0x00, 0x08, 0x08, 0x08, 0x7F, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char +
+	0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x20, 0x20, 0x00,  // Code for char ,
+	0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char -
+	0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00,  // Code for char .
+	0x04, 0x00, 0x10, 0x10, 0x20, 0x20, 0x20, 0x20, 0x40, 0x40, 0x40, 0x40, 0x80, 0x80, 0x00, 0x00, 0x00,  // Code for char /
+	0x08, 0x00, 0x1C, 0x22, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x22, 0x1C, 0x00, 0x00, 0x00,  // Code for char 0
+	0x06, 0x00, 0x04, 0x0C, 0x14, 0x24, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00, 0x00,  // Code for char 1
+	0x08, 0x00, 0x1E, 0x22, 0x41, 0x01, 0x01, 0x02, 0x02, 0x04, 0x08, 0x10, 0x20, 0x7F, 0x00, 0x00, 0x00,  // Code for char 2
+	0x08, 0x00, 0x1C, 0x22, 0x42, 0x02, 0x06, 0x1C, 0x02, 0x01, 0x01, 0x41, 0x62, 0x1C, 0x00, 0x00, 0x00,  // Code for char 3
+	0x09, 0x00, 0x00, 0x01, 0x00, 0x03, 0x00, 0x05, 0x00, 0x09, 0x00, 0x09, 0x00, 0x11, 0x00, 0x21, 0x00, 0x41, 0x00, 0x7F, 0x80, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char 4
+	0x08, 0x00, 0x3F, 0x20, 0x20, 0x40, 0x7C, 0x42, 0x01, 0x01, 0x01, 0x41, 0x22, 0x1C, 0x00, 0x00, 0x00,  // Code for char 5
+	0x08, 0x00, 0x1C, 0x22, 0x41, 0x40, 0x5C, 0x62, 0x41, 0x41, 0x41, 0x41, 0x22, 0x1C, 0x00, 0x00, 0x00,  // Code for char 6
+	0x08, 0x00, 0x7F, 0x02, 0x02, 0x04, 0x04, 0x08, 0x08, 0x08, 0x08, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00,  // Code for char 7
+	0x08, 0x00, 0x1C, 0x22, 0x41, 0x41, 0x22, 0x1C, 0x22, 0x41, 0x41, 0x41, 0x22, 0x1C, 0x00, 0x00, 0x00,  // Code for char 8
+	0x08, 0x00, 0x1C, 0x22, 0x41, 0x41, 0x41, 0x41, 0x23, 0x1D, 0x01, 0x41, 0x22, 0x1C, 0x00, 0x00, 0x00,  // Code for char 9
+	0x02, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00,  // Code for char :
+	0x02, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x40, 0x40, 0x00,  // Code for char ;
+	0x08, 0x00, 0x00, 0x00, 0x00, 0x01, 0x0E, 0x30, 0x40, 0x30, 0x0E, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char <
+	0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x00, 0x00, 0x00, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char =
+	0x08, 0x00, 0x00, 0x00, 0x00, 0x40, 0x38, 0x06, 0x01, 0x06, 0x38, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char >
+	0x08, 0x00, 0x1C, 0x22, 0x41, 0x41, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08, 0x00, 0x08, 0x00, 0x00, 0x00,  // Code for char ?
+	0x10, 0x00, 0x00, 0x03, 0xF0, 0x0C, 0x0C, 0x10, 0x02, 0x21, 0xD2, 0x22, 0x31, 0x44, 0x11, 0x48, 0x11, 0x48, 0x21, 0x48, 0x21, 0x48, 0x22, 0x44, 0x64, 0x23, 0xB8, 0x10, 0x01, 0x0C, 0x06, 0x03, 0xF8,  // Code for char @
+	0x0A, 0x00, 0x00, 0x04, 0x00, 0x0A, 0x00, 0x0A, 0x00, 0x0A, 0x00, 0x11, 0x00, 0x11, 0x00, 0x11, 0x00, 0x3F, 0x80, 0x20, 0x80, 0x20, 0x80, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char A
+	0x0A, 0x00, 0x00, 0x7F, 0x80, 0x40, 0x80, 0x40, 0x40, 0x40, 0x40, 0x40, 0x80, 0x7F, 0x00, 0x40, 0x80, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x80, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char B
+	0x0B, 0x00, 0x00, 0x0F, 0x80, 0x10, 0x40, 0x20, 0x20, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x20, 0x20, 0x10, 0x40, 0x0F, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char C
+	0x0B, 0x00, 0x00, 0x7F, 0x00, 0x40, 0x80, 0x40, 0x40, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x40, 0x40, 0x40, 0x80, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char D
+	0x0A, 0x00, 0x00, 0x7F, 0xC0, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x7F, 0x80, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x7F, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char E
+	0x09, 0x00, 0x00, 0x7F, 0x80, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x7F, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char F
+	0x0B, 0x00, 0x00, 0x0F, 0x00, 0x10, 0x80, 0x20, 0x40, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x43, 0xE0, 0x40, 0x20, 0x40, 0x20, 0x20, 0x40, 0x10, 0x80, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char G
+	0x0A, 0x00, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x7F, 0xC0, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char H
+	0x02, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00,  // Code for char I
+	0x07, 0x00, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x42, 0x42, 0x42, 0x3C, 0x00, 0x00, 0x00,  // Code for char J
+	0x0A, 0x00, 0x00, 0x40, 0x40, 0x40, 0x80, 0x41, 0x00, 0x42, 0x00, 0x44, 0x00, 0x4C, 0x00, 0x54, 0x00, 0x62, 0x00, 0x41, 0x00, 0x41, 0x00, 0x40, 0x80, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char K
+	0x08, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x7F, 0x00, 0x00, 0x00,  // Code for char L
+	0x0C, 0x00, 0x00, 0x40, 0x10, 0x60, 0x30, 0x60, 0x30, 0x50, 0x50, 0x50, 0x50, 0x48, 0x90, 0x48, 0x90, 0x45, 0x10, 0x45, 0x10, 0x45, 0x10, 0x42, 0x10, 0x42, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char M
+	0x0A, 0x00, 0x00, 0x40, 0x40, 0x60, 0x40, 0x50, 0x40, 0x50, 0x40, 0x48, 0x40, 0x44, 0x40, 0x44, 0x40, 0x42, 0x40, 0x41, 0x40, 0x41, 0x40, 0x40, 0xC0, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char N
+	0x0B, 0x00, 0x00, 0x0F, 0x00, 0x10, 0x80, 0x20, 0x40, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x20, 0x40, 0x10, 0x80, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char O
+	0x0A, 0x00, 0x00, 0x7F, 0x00, 0x40, 0x80, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x80, 0x7F, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char P
+	0x0B, 0x00, 0x00, 0x0F, 0x00, 0x10, 0x80, 0x20, 0x40, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x40, 0x20, 0x23, 0x60, 0x10, 0xC0, 0x0F, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char Q
+	0x0A, 0x00, 0x00, 0x7F, 0x00, 0x40, 0x80, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x80, 0x7F, 0x00, 0x42, 0x00, 0x41, 0x00, 0x41, 0x00, 0x40, 0x80, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char R
+	0x0A, 0x00, 0x00, 0x1F, 0x00, 0x20, 0x80, 0x40, 0x40, 0x40, 0x00, 0x20, 0x00, 0x1C, 0x00, 0x03, 0x80, 0x00, 0x40, 0x00, 0x40, 0x40, 0x40, 0x20, 0x80, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char S
+	0x09, 0x00, 0x00, 0xFF, 0x80, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char T
+	0x0A, 0x00, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x20, 0x80, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char U
+	0x0A, 0x00, 0x00, 0x40, 0x40, 0x40, 0x40, 0x20, 0x80, 0x20, 0x80, 0x20, 0x80, 0x11, 0x00, 0x11, 0x00, 0x11, 0x00, 0x0A, 0x00, 0x0A, 0x00, 0x04, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char V
+	0x0F, 0x00, 0x00, 0x81, 0x02, 0x82, 0x82, 0x42, 0x84, 0x42, 0x84, 0x44, 0x44, 0x44, 0x44, 0x24, 0x48, 0x28, 0x28, 0x28, 0x28, 0x28, 0x28, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char W
+	0x0B, 0x00, 0x00, 0x40, 0x40, 0x20, 0x80, 0x11, 0x00, 0x11, 0x00, 0x0A, 0x00, 0x04, 0x00, 0x0A, 0x00, 0x11, 0x00, 0x11, 0x00, 0x20, 0x80, 0x40, 0x40, 0x80, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char X
+	0x09, 0x00, 0x00, 0x80, 0x80, 0x41, 0x00, 0x41, 0x00, 0x22, 0x00, 0x14, 0x00, 0x14, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char Y
+	0x09, 0x00, 0x00, 0x7F, 0x80, 0x01, 0x00, 0x02, 0x00, 0x02, 0x00, 0x04, 0x00, 0x08, 0x00, 0x08, 0x00, 0x10, 0x00, 0x20, 0x00, 0x20, 0x00, 0x40, 0x00, 0xFF, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char Z
+	0x04, 0x00, 0x70, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x70,  // Code for char [
+	0x04, 0x00, 0x80, 0x80, 0x40, 0x40, 0x40, 0x40, 0x20, 0x20, 0x20, 0x20, 0x10, 0x10, 0x00, 0x00, 0x00,  // Code for char BackSlash
+	0x03, 0x00, 0xE0, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0xE0,  // Code for char ]
+	0x07, 0x00, 0x10, 0x28, 0x28, 0x44, 0x44, 0x82, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char ^
+	0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x80,  // Code for char _
+	0x03, 0x00, 0x40, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char `
+	0x08, 0x00, 0x00, 0x00, 0x00, 0x1E, 0x21, 0x41, 0x07, 0x39, 0x41, 0x41, 0x43, 0x3D, 0x00, 0x00, 0x00,  // Code for char a
+	0x08, 0x00, 0x40, 0x40, 0x40, 0x5C, 0x62, 0x41, 0x41, 0x41, 0x41, 0x41, 0x62, 0x5C, 0x00, 0x00, 0x00,  // Code for char b
+	0x07, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x22, 0x40, 0x40, 0x40, 0x40, 0x40, 0x22, 0x1C, 0x00, 0x00, 0x00,  // Code for char c
+	0x08, 0x00, 0x01, 0x01, 0x01, 0x1D, 0x23, 0x41, 0x41, 0x41, 0x41, 0x41, 0x23, 0x1D, 0x00, 0x00, 0x00,  // Code for char d
+	0x08, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x22, 0x41, 0x41, 0x7F, 0x40, 0x41, 0x22, 0x1C, 0x00, 0x00, 0x00,  // Code for char e
+	0x04, 0x00, 0x30, 0x40, 0x40, 0xF0, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00,  // Code for char f
+	0x08, 0x00, 0x00, 0x00, 0x00, 0x1D, 0x23, 0x41, 0x41, 0x41, 0x41, 0x41, 0x23, 0x1D, 0x01, 0x42, 0x3C,  // Code for char g
+	0x07, 0x00, 0x40, 0x40, 0x40, 0x5C, 0x62, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00,  // Code for char h
+	0x02, 0x00, 0x40, 0x00, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00,  // Code for char i
+	0x02, 0x00, 0x40, 0x00, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x80,  // Code for char j
+	0x08, 0x00, 0x40, 0x40, 0x40, 0x41, 0x42, 0x44, 0x48, 0x58, 0x64, 0x44, 0x42, 0x41, 0x00, 0x00, 0x00,  // Code for char k
+	0x02, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00,  // Code for char l
+	0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5C, 0xE0, 0x63, 0x10, 0x42, 0x10, 0x42, 0x10, 0x42, 0x10, 0x42, 0x10, 0x42, 0x10, 0x42, 0x10, 0x42, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char m
+	0x07, 0x00, 0x00, 0x00, 0x00, 0x5C, 0x62, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00,  // Code for char n
+	0x08, 0x00, 0x00, 0x00, 0x00, 0x1C, 0x22, 0x41, 0x41, 0x41, 0x41, 0x41, 0x22, 0x1C, 0x00, 0x00, 0x00,  // Code for char o
+	0x08, 0x00, 0x00, 0x00, 0x00, 0x5C, 0x62, 0x41, 0x41, 0x41, 0x41, 0x41, 0x62, 0x5C, 0x40, 0x40, 0x40,  // Code for char p
+	0x08, 0x00, 0x00, 0x00, 0x00, 0x1D, 0x23, 0x41, 0x41, 0x41, 0x41, 0x41, 0x23, 0x1D, 0x01, 0x01, 0x01,  // Code for char q
+	0x05, 0x00, 0x00, 0x00, 0x00, 0x58, 0x60, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00,  // Code for char r
+	0x07, 0x00, 0x00, 0x00, 0x00, 0x3C, 0x42, 0x40, 0x40, 0x3C, 0x02, 0x02, 0x42, 0x3C, 0x00, 0x00, 0x00,  // Code for char s
+	0x04, 0x00, 0x00, 0x40, 0x40, 0xF0, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x70, 0x00, 0x00, 0x00,  // Code for char t
+	0x07, 0x00, 0x00, 0x00, 0x00, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x46, 0x3A, 0x00, 0x00, 0x00,  // Code for char u
+	0x07, 0x00, 0x00, 0x00, 0x00, 0x82, 0x82, 0x44, 0x44, 0x28, 0x28, 0x28, 0x10, 0x10, 0x00, 0x00, 0x00,  // Code for char v
+	0x0B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x84, 0x20, 0x84, 0x20, 0x4A, 0x40, 0x4A, 0x40, 0x51, 0x40, 0x51, 0x40, 0x51, 0x40, 0x20, 0x80, 0x20, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char w
+	0x07, 0x00, 0x00, 0x00, 0x00, 0x82, 0x44, 0x28, 0x28, 0x10, 0x28, 0x28, 0x44, 0x82, 0x00, 0x00, 0x00,  // Code for char x
+	0x07, 0x00, 0x00, 0x00, 0x00, 0x82, 0x82, 0x84, 0x44, 0x44, 0x28, 0x28, 0x28, 0x10, 0x10, 0x10, 0x60,  // Code for char y
+	0x07, 0x00, 0x00, 0x00, 0x00, 0xFE, 0x04, 0x08, 0x08, 0x10, 0x20, 0x20, 0x40, 0xFE, 0x00, 0x00, 0x00,  // Code for char z
+	0x05, 0x00, 0x18, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0xC0, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x18,  // Code for char {
+	0x02, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,  // Code for char |
+	0x05, 0x00, 0xC0, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x18, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0xC0,  // Code for char }
+	0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x71, 0x8E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Code for char ~
+	0x04, 0x00, 0xF0, 0x90, 0x90, 0x90, 0x90, 0x90, 0x90, 0x90, 0x90, 0x90, 0xF0, 0x00, 0x00, 0x00, 0x00,  // Code for char 0x7F
+};
+
+static const uint16_t glcd16x16PackedIndex[] PROGMEM =
+{
+	0, 17, 34, 51, 84, 101, 134, 167, 184, 201, 218, 235, 252, 269, 286, 303,
+	320, 337, 354, 371, 388, 421, 438, 455, 472, 489, 506, 523, 540, 557, 574, 591,
+	608, 641, 674, 707, 740, 773, 806, 839, 872, 905, 922, 939, 972, 989, 1022, 1055,
+	1088, 1121, 1154, 1187, 1220, 1253, 1286, 1319, 1352, 1385, 1418, 1451, 1468, 1485, 1502, 1519,
+	1552, 1569, 1586, 1603, 1620, 1637, 1654, 1671, 1688, 1705, 1722, 1739, 1756, 1773, 1806, 1823,
+	1840, 1857, 1874, 1891, 1908, 1925, 1942, 1959, 1992, 2009, 2026, 2043, 2060, 2077, 2094, 2111,
+};
+
+extern const PROGMEM LcdFont font16x16Packed =
+{
+	glcd16x16Packed,		// font data
+	0x0020,			// first character code
+	0x007F,			// last character code
+	16,				// row height in pixels
+	16,				// max character width in pixels
+	1,				// number of space pixels between characters before kerning
+	glcd16x16PackedIndex	// character offsets, so this font is in packed format
+};
+
+
+// End
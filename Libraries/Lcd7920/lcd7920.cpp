@@ -26,15 +26,38 @@ const unsigned int LcdDisplayClearDelayMillis = 3;  // 1.6ms should be enough
 
 const unsigned int numRows = 64;
 const unsigned int numCols = 128;
+#if LCD7920_ALPHA
+const uint8_t numTextLines = 4;             // lines of text in alphanumeric mode
+const uint8_t numTextCells = 8;             // 16-pixel character cells per line, each holding 2 characters
+#endif
+
+// If there are no more than this many clean words between two dirty words in a row, it is quicker to send the clean words too than to set the address again
+const uint8_t maxGapWords = 2;
+
+// Default time source for timing the display command delays
+static uint16_t defaultTimeSource()
+{
+	return (uint16_t)micros();
+}
 
 Lcd7920::Lcd7920(uint8_t p_clockPin, uint8_t p_dataPin, uint8_t p_csPin, bool spi)
-	: useSpi(spi), textInverted(false), justSetCursor(false), clockPin(p_clockPin), dataPin(p_dataPin), csPin(p_csPin), currentFont(nullptr)
+	: useSpi(spi), textInverted(false), justSetCursor(false), flushing(false), spiBusy(false), clockPin(p_clockPin), dataPin(p_dataPin), csPin(p_csPin),
+	  bytesSent(0), timeSource(defaultTimeSource), timeResolution(4), currentFont(nullptr)
+{
+}
+
+void Lcd7920::setTimeSource(uint16_t (*f)(), uint8_t resolution)
 {
+	timeSource = f;
+	timeResolution = resolution;
 }
 
 // NB - if using SPI then the SS pin must be set to be an output before calling this, or else csPin must be the SS pin!
-void Lcd7920::begin()
+void Lcd7920::begin(bool gmode)
 {
+#if LCD7920_ALPHA
+	graphicsMode = gmode;
+#endif
 	// Set up the SPI interface for talking to the LCD. We have to set MOSI, SCLK and SS to outputs, then enable SPI.
 	pinMode(csPin, OUTPUT);
 	digitalWrite(csPin, LOW);				// CS is active high on the ST7920
@@ -65,6 +88,10 @@ void Lcd7920::begin()
 	commandDelay();
 	DeassertCS();
 
+#if LCD7920_ALPHA
+	memset(text, ' ', sizeof(text));			// the display clear command filled the alpha RAM with spaces
+	memset(textDirty, 0, sizeof(textDirty));
+#endif
 	clear();  									          // clear graphics ram
 	flush();
 
@@ -78,6 +105,17 @@ void Lcd7920::begin()
 
 size_t Lcd7920::write(uint8_t ch)
 {
+#if LCD7920_ALPHA
+	if (!graphicsMode)
+	{
+		if (ch == '\n')
+		{
+			setCursor(row + 16, 0);
+			return 1;
+		}
+		return writeText(ch);
+	}
+#endif
 	if (ch == '\n')
 	{
 		setCursor(row + currentFont->height + 1, 0);
@@ -94,90 +132,180 @@ size_t Lcd7920::write(uint8_t ch)
 				return 0;
 			}
 
-			const uint8_t fontWidth = pgm_read_byte_near(&(currentFont->width));
 			const uint8_t fontHeight = pgm_read_byte_near(&(currentFont->height));
-			const uint8_t bytesPerColumn = (fontHeight + 7)/8;
-			const uint8_t bytesPerChar = (bytesPerColumn * fontWidth) + 1;
-			const PROGMEM_PTR uint8_t * PROGMEM fontPtr = (const PROGMEM_PTR uint8_t*)pgm_read_word_near(&(currentFont->ptr)) + (bytesPerChar * (ch - startChar));
-			uint16_t cmask = (1u << fontHeight) - 1u;
-
-			uint8_t nCols = pgm_read_byte_near(fontPtr++);
-
-			// Update dirty rectangle coordinates, except for endCol which we do at the end      
+			const uint8_t startColumn = column;
+			const PROGMEM_PTR uint16_t *index = (const PROGMEM_PTR uint16_t*)pgm_read_word_near(&(currentFont->index));
+			if (index != nullptr)
 			{
-			  if (startRow > row) { startRow = row; }
-			  if (startCol > column) { startCol = column; }
-			  uint8_t nextRow = row + fontHeight;
-			  if (nextRow > numRows) { nextRow = numRows; }
-			  if (endRow < nextRow) { endRow = nextRow; }
+				const PROGMEM_PTR uint8_t *glyph = (const PROGMEM_PTR uint8_t*)pgm_read_word_near(&(currentFont->ptr)) + pgm_read_word_near(index + (ch - startChar));
+				writePacked(glyph, fontHeight);
 			}
-
-			// Decide whether to add a space column first (auto-kerning)
-			// We don't add a space column before a space character.
-			// We add a space column after a space character if we would have added one between the preceding and following characters.
-			if (column < rightMargin)
+			else
 			{
-			  uint16_t thisCharColData = pgm_read_word_near(fontPtr) & cmask;    // atmega328p is little-endian
-			  if (thisCharColData == 0)  // for characters with deliberate space row at the start, e.g. decimal point
-			  {
-				  thisCharColData = pgm_read_word_near(fontPtr + 2) & cmask;
-			  }
-			  bool wantSpace = ((thisCharColData | (thisCharColData << 1)) & (lastCharColData | (lastCharColData << 1))) != 0;
-			  if (wantSpace)
-			  {
-  				// Add space after character
-  				uint8_t mask = 0x80 >> (column & 7);
-  				uint8_t *p = image + ((row * (numCols/8)) + (column/8));
-  				for (uint8_t i = 0; i < fontHeight && p < (image + sizeof(image)); ++i)
-  				{
-  				  if (textInverted)
-  				  {
-  			  		*p |= mask;
-  				  }
-  				  else
-  				  {
-  					  *p &= ~mask;
-  				  }
-  				  p += (numCols/8);
-  				}
-  				++column;
-			  }      
+				const uint8_t fontWidth = pgm_read_byte_near(&(currentFont->width));
+				const uint8_t bytesPerColumn = (fontHeight + 7)/8;
+				const uint8_t bytesPerChar = (bytesPerColumn * fontWidth) + 1;
+				const PROGMEM_PTR uint8_t * PROGMEM fontPtr = (const PROGMEM_PTR uint8_t*)pgm_read_word_near(&(currentFont->ptr)) + (bytesPerChar * (ch - startChar));
+				uint16_t cmask = (1u << fontHeight) - 1u;
+
+				uint8_t nCols = pgm_read_byte_near(fontPtr++);
+
+				// Decide whether to add a space column first (auto-kerning)
+				// We don't add a space column before a space character.
+				// We add a space column after a space character if we would have added one between the preceding and following characters.
+				uint16_t thisCharColData = pgm_read_word_near(fontPtr) & cmask;    // atmega328p is little-endian
+				if (thisCharColData == 0)  // for characters with deliberate space row at the start, e.g. decimal point
+				{
+					thisCharColData = pgm_read_word_near(fontPtr + 2) & cmask;
+				}
+				bool wantSpace = ((thisCharColData | (thisCharColData << 1)) & (lastCharColData | (lastCharColData << 1))) != 0;
+
+				// Draw the space column (if wanted) and the glyph columns. Rather than updating the image one pixel at a time, we shift each column
+				// into one byte per pixel row, and store those bytes each time we reach a byte boundary or the end of the character.
+				// This way each store writes up to 8 pixels.
+				const uint8_t rowsToDraw = (row >= numRows) ? 0 : (row + fontHeight > numRows) ? numRows - row : fontHeight;
+				uint8_t rowBits[16] = { 0 };
+				uint8_t chunkStart = column;
+				while ((wantSpace || nCols != 0) && column < rightMargin)
+				{
+					uint16_t colData;
+					if (wantSpace)
+					{
+						colData = 0;
+						wantSpace = false;
+					}
+					else
+					{
+						colData = pgm_read_word_near(fontPtr);
+						fontPtr += bytesPerColumn;
+						if (colData != 0)
+						{
+							lastCharColData = colData & cmask;
+						}
+						--nCols;
+					}
+					for (uint8_t i = 0; i < rowsToDraw; ++i)
+					{
+						rowBits[i] = (rowBits[i] << 1) | (uint8_t)(colData & 1u);
+						colData >>= 1;
+					}
+					++column;
+					if ((column & 7) == 0 || column == rightMargin || nCols == 0)
+					{
+						storeColumns(chunkStart, column, rowBits, rowsToDraw);
+						chunkStart = column;
+					}
+				}
 			}
 
-			while (nCols != 0 && column < rightMargin)
+			markDirty(row, row + fontHeight, startColumn, column);
+		}
+		justSetCursor = false;
+	}
+	return 1;
+}
+
+#if LCD7920_ALPHA
+
+// Write a character in alphanumeric mode. The display holds 2 characters in each 16-pixel cell, so we record which cells have changed.
+size_t Lcd7920::writeText(uint8_t ch)
+{
+	if (ch < 0x20 || ch > 0x7E)
+	{
+		return 0;											// not in the half-width character set of the display
+	}
+	if (column + 8 <= rightMargin)
+	{
+		const uint8_t line = row/16;
+		const uint8_t pos = column/8;
+		if (line < numTextLines && text[line][pos] != (char)ch)
+		{
+			text[line][pos] = ch;
+			textDirty[line] |= (1u << (pos/2));
+		}
+		column = (pos + 1) * 8;
+	}
+	justSetCursor = false;
+	return 1;
+}
+
+#endif
+
+// Return 8 pixels from one row of a character in packed format, starting at pixel firstBit, with the first pixel in the most significant bit.
+// firstBit may be negative. Pixels outside the character are returned as zero.
+static uint8_t packedBits(const PROGMEM_PTR uint8_t *rowPtr, uint8_t bytesPerRow, int8_t firstBit)
+{
+	const uint8_t offset = firstBit & 7;
+	const int8_t byteIndex = (firstBit - (int8_t)offset)/8;
+	const uint8_t hi = (byteIndex >= 0 && byteIndex < bytesPerRow) ? pgm_read_byte_near(rowPtr + byteIndex) : 0;
+	const uint8_t lo = (byteIndex + 1 >= 0 && byteIndex + 1 < bytesPerRow) ? pgm_read_byte_near(rowPtr + byteIndex + 1) : 0;
+	return (uint8_t)((hi << offset) | (lo >> (8 - offset)));
+}
+
+// Return one column of a character in packed format, with the top pixel in the least significant bit, as stored in column-major fonts.
+static uint16_t packedColumn(const PROGMEM_PTR uint8_t *glyph, uint8_t bytesPerRow, uint8_t fontHeight, uint8_t col)
+{
+	uint16_t colData = 0;
+	if (col/8 < bytesPerRow)
+	{
+		const uint8_t mask = 0x80 >> (col & 7);
+		glyph += col/8;
+		for (uint8_t i = 0; i < fontHeight; ++i)
+		{
+			if (pgm_read_byte_near(glyph) & mask)
 			{
-			  uint16_t colData = pgm_read_word_near(fontPtr);
-			  fontPtr += bytesPerColumn;
-			  if (colData != 0)
-			  {
-				  lastCharColData = colData & cmask;
-			  }
-			  uint8_t mask1 = 0x80 >> (column & 7);
-			  uint8_t mask2 = ~mask1;
-			  uint8_t *p = image + ((row * (numCols/8)) + (column/8));
-			  const uint16_t setPixelVal = (textInverted) ? 0 : 1;
-			  for (uint8_t i = 0; i < fontHeight && p < (image + sizeof(image)); ++i)
-			  {
-  				if ((colData & 1u) == setPixelVal)
-  				{
-  				  *p |= mask1;      // set pixel
-  				}
-  				else
-  				{
-  				  *p &= mask2;     // clear pixel
-  				}
-  				colData >>= 1;
-  				p += (numCols/8);
-			  }
-			  --nCols;
-			  ++column;
+				colData |= (1u << i);
 			}
+			glyph += bytesPerRow;
+		}
+	}
+	return colData;
+}
 
-			if (column > endCol) { endCol = column; }
+// Draw a character from a font in packed row-major format, where glyph points to the width byte of the character.
+// Because the rows are already in the same layout as the image, we fetch up to 8 pixels from each row at a time.
+void Lcd7920::writePacked(const PROGMEM_PTR uint8_t *glyph, uint8_t fontHeight)
+{
+	const uint8_t nCols = pgm_read_byte_near(glyph++);
+	const uint8_t bytesPerRow = (nCols + 7)/8;
+
+	// Decide whether to add a space column first (auto-kerning), using the same rules as for column-major fonts
+	uint16_t thisCharColData = packedColumn(glyph, bytesPerRow, fontHeight, 0);
+	if (thisCharColData == 0)
+	{
+		thisCharColData = packedColumn(glyph, bytesPerRow, fontHeight, 1);
+	}
+	const bool wantSpace = ((thisCharColData | (thisCharColData << 1)) & (lastCharColData | (lastCharColData << 1))) != 0;
+
+	const uint8_t glyphStart = (wantSpace) ? column + 1 : column;
+	const uint8_t endColumn = (glyphStart + nCols < rightMargin) ? glyphStart + nCols : rightMargin;
+	const uint8_t rowsToDraw = (row >= numRows) ? 0 : (row + fontHeight > numRows) ? numRows - row : fontHeight;
+	uint8_t rowBits[16] = { 0 };
+	while (column < endColumn)
+	{
+		const uint8_t chunkEnd = ((column | 7) + 1 < endColumn) ? (column | 7) + 1 : endColumn;
+		const int8_t firstBit = (int8_t)(chunkEnd - 8 - glyphStart);		// so that the last pixel fetched is for column chunkEnd - 1
+		const PROGMEM_PTR uint8_t *rowPtr = glyph;
+		for (uint8_t i = 0; i < rowsToDraw; ++i)
+		{
+			rowBits[i] = packedBits(rowPtr, bytesPerRow, firstBit);
+			rowPtr += bytesPerRow;
+		}
+		storeColumns(column, chunkEnd, rowBits, rowsToDraw);
+		column = chunkEnd;
+	}
+
+	// Record the last non-blank column we drew, for kerning the next character
+	for (uint8_t col = (endColumn > glyphStart) ? endColumn - glyphStart : 0; col != 0; )
+	{
+		--col;
+		const uint16_t colData = packedColumn(glyph, bytesPerRow, fontHeight, col);
+		if (colData != 0)
+		{
+			lastCharColData = colData;
+			break;
 		}
-		justSetCursor = false;
 	}
-	return 1;
 }
 
 // Set the right margin. In graphics mode, anything written will be truncated at the right margin. Defaults to the right hand edge of the display.
@@ -189,43 +317,62 @@ void Lcd7920::setRightMargin(uint8_t r)
 // Clear a rectangle from the current position to the right margin (graphics mode only). The height of the rectangle is the height of the current font.
 void Lcd7920::clearToMargin()
 {
+#if LCD7920_ALPHA
+	if (!graphicsMode)
+	{
+		while (column + 8 <= rightMargin)
+		{
+			writeText(' ');
+		}
+		return;
+	}
+#endif
 	if (currentFont != nullptr)
 	{
 		if (column < rightMargin)
 		{
 			const uint8_t fontHeight = pgm_read_byte_near(&(currentFont->height));
-			// Update dirty rectangle coordinates
-			{
-			  if (startRow > row) { startRow = row; }
-			  if (startCol > column) { startCol = column; }
-			  uint8_t nextRow = row + fontHeight;
-			  if (nextRow > numRows) { nextRow = numRows; }
-			  if (endRow < nextRow) { endRow = nextRow; }
-			  if (endCol < rightMargin) { endCol = rightMargin; }
-			}
+			markDirty(row, row + fontHeight, column, rightMargin);
+			const uint8_t rowsToDraw = (row >= numRows) ? 0 : (row + fontHeight > numRows) ? numRows - row : fontHeight;
 			while (column < rightMargin)
 			{
-				// Add space after character
-				uint8_t mask = 0x80 >> (column & 7);
-				uint8_t *p = image + ((row * (numCols/8)) + (column/8));
-				for (uint8_t i = 0; i < fontHeight && p < (image + sizeof(image)); ++i)
-				{
-				  if (textInverted)
-				  {
-					  *p |= mask;
-				  }
-				  else
-				  {
-					  *p &= ~mask;
-				  }
-				  p += (numCols/8);
-				}
-				++column;
+				const uint8_t chunkEnd = ((column | 7) + 1 < rightMargin) ? (column | 7) + 1 : rightMargin;
+				storeColumns(column, chunkEnd, nullptr, rowsToDraw);
+				column = chunkEnd;
 			}
 		}
 	}
 }
 
+// Store the pixels for columns c0 to c1-1 of the current text row, where these columns all lie within one byte of the image.
+// rowBits holds one byte per pixel row with the pixel for column c1-1 in the least significant bit, or is nullptr to store background.
+// Pixels are set where the corresponding bit is 1 in normal mode or 0 in inverted mode.
+void Lcd7920::storeColumns(uint8_t c0, uint8_t c1, const uint8_t *rowBits, uint8_t nRows)
+{
+	const uint8_t shift = (8 - (c1 & 7)) & 7;
+	const uint8_t mask = (0xFF >> (c0 & 7)) & (uint8_t)(0xFF << shift);
+	const uint8_t invert = (textInverted) ? 0xFF : 0;
+	uint8_t *p = image + ((row * (numCols/8)) + (c0/8));
+	if (mask == 0xFF)
+	{
+		// Byte-aligned fast path, no need to read the old image data
+		for (uint8_t i = 0; i < nRows; ++i)
+		{
+			*p = ((rowBits == nullptr) ? 0 : rowBits[i]) ^ invert;
+			p += (numCols/8);
+		}
+	}
+	else
+	{
+		for (uint8_t i = 0; i < nRows; ++i)
+		{
+			const uint8_t bits = (((rowBits == nullptr) ? 0 : (uint8_t)(rowBits[i] << shift)) ^ invert) & mask;
+			*p = (*p & ~mask) | bits;
+			p += (numCols/8);
+		}
+	}
+}
+
 // Select normal or inverted text (only works in graphics mode)
 void Lcd7920::textInvert(bool b)
 {
@@ -248,10 +395,24 @@ void Lcd7920::clear()
 {
   memset(image, 0, sizeof(image));
   // Now flag the whole image as dirty
-  startRow = 0;
-  endRow = numRows;
-  startCol = 0;
-  endCol = numCols;
+  memset(dirtyWords, 0xFF, sizeof(dirtyWords));
+#if LCD7920_SHADOW
+  shadowValid = false;
+#endif
+#if LCD7920_ALPHA
+  // Blank the text too. We know what the display holds, so only the cells that weren't already blank need to be sent.
+  for (uint8_t line = 0; line < numTextLines; ++line)
+  {
+    for (uint8_t pos = 0; pos < 2 * numTextCells; ++pos)
+    {
+      if (text[line][pos] != ' ')
+      {
+        text[line][pos] = ' ';
+        textDirty[line] |= (1u << (pos/2));
+      }
+    }
+  }
+#endif
   setCursor(0, 0);
   textInverted = false;
   rightMargin = numCols;
@@ -335,39 +496,313 @@ void Lcd7920::bitmap(uint8_t x0, uint8_t y0, uint8_t width, uint8_t height, cons
       *p++ = pgm_read_byte_near(data + bitMapOffset++);
     }
   }
-  if (x0 < startCol) startCol = x0;
-  if (x0 + width > endCol) endCol = x0 + width;
-  if (y0 < startRow) startRow = y0;
-  if (y0 + height > endRow) endRow = y0 + height;
+  markDirty(y0, y0 + height, x0, x0 + width);
+}
+
+// Flag the words covering rows r0 to r1-1 and columns c0 to c1-1 as dirty, clipping them to the display
+void Lcd7920::markDirty(uint8_t r0, uint8_t r1, uint8_t c0, uint8_t c1)
+{
+  if (r1 > numRows) { r1 = numRows; }
+  if (c1 > numCols) { c1 = numCols; }
+  if (r0 < r1 && c0 < c1)
+  {
+    // Bits (c0/16) to ((c1-1)/16) inclusive
+    const uint8_t mask = (uint8_t)((2u << ((c1 - 1)/16)) - (1u << (c0/16)));
+    for (uint8_t r = r0; r < r1; ++r)
+    {
+      dirtyWords[r] |= mask;
+    }
+  }
 }
 
 // Flush the dirty part of the image to the lcd
 void Lcd7920::flush()
 {
-  if (endCol > startCol && endRow > startRow)
+  while (flushStep()) { }           // finish any flush that is already in progress
+  beginFlush();
+  while (flushStep()) { }
+}
+
+void Lcd7920::beginFlush()
+{
+  if (!flushing)
+  {
+    bytesSent = 0;
+    flushing = true;
+    flushCsAsserted = false;
+    flushRow = 0xFF;                  // so that moving on to the next row takes us to row 0
+    flushRowDirty = 0;
+#if LCD7920_ALPHA
+    flushingText = true;              // we send the changed characters first
+    flushBasicMode = false;
+#endif
+    flushRunWord = 1;
+    flushRunEnd = 0;
+    txLength = txPos = 0;
+    txDelay = 0;
+    delayStarted = false;
+  }
+}
+
+bool Lcd7920::flushStep()
+{
+  while (flushing)
+  {
+    if (txPos < txLength)
+    {
+      if (!spiReady())
+      {
+        return true;
+      }
+      const uint8_t data = txBuffer[txPos++];
+      if (useSpi)
+      {
+        SPDR = data;
+        spiBusy = true;
+      }
+      else
+      {
+        sendLcdSlow(data);
+      }
+      ++bytesSent;
+    }
+    else if (txDelay != 0)
+    {
+      // The delay starts when the last byte has been sent
+      if (!spiReady())
+      {
+        return true;
+      }
+      if (!delayStarted)
+      {
+        delayStart = timeSource();
+        delayStarted = true;
+      }
+      if ((uint16_t)(timeSource() - delayStart) < (uint16_t)txDelay + timeResolution)
+      {
+        return true;
+      }
+      txDelay = 0;
+      delayStarted = false;
+    }
+    else if (!queueNextFlushUnit())
+    {
+      if (!spiReady())
+      {
+        return true;
+      }
+      if (flushCsAsserted)
+      {
+        DeassertCS();
+      }
+      flushing = false;
+#if LCD7920_SHADOW
+      shadowValid = true;
+#endif
+    }
+  }
+  return false;
+}
+
+// Put the bytes for the next address command or data word of the flush in the transmit buffer.
+// Return false if there is nothing left to send.
+bool Lcd7920::queueNextFlushUnit()
+{
+  for (;;)
+  {
+    // If we are part way through a run of words, send the next one.
+    // The display auto-increments the address after each word, so we only need to set it at the start of each run of dirty words.
+    if (flushRunWord <= flushRunEnd)
+    {
+#if LCD7920_ALPHA
+      if (flushingText)
+      {
+        queueData((const uint8_t*)text[flushRow] + (2 * flushRunWord));
+      }
+      else
+#endif
+      {
+        const uint8_t *ptr = image + (((numCols/8) * flushRow) + (2 * flushRunWord));
+        queueData(ptr);
+#if LCD7920_SHADOW
+        recordSentWord(flushRow, flushRunWord, ptr);
+#endif
+      }
+      ++flushRunWord;
+      flushNextWord = flushRunWord;
+      return true;
+    }
+
+    // Look for the next dirty word in this row
+    if (flushRowDirty != 0)
+    {
+      uint8_t w = 0;
+      uint8_t mask = 1;
+      while ((flushRowDirty & mask) == 0)
+      {
+        ++w;
+        mask <<= 1;
+      }
+      flushRowDirty &= ~mask;
+      flushRunEnd = w;
+      if (w > flushNextWord && w - flushNextWord <= maxGapWords)
+      {
+        flushRunWord = flushNextWord;     // the gap is small, so send the clean words in it instead of setting the address again
+      }
+      else
+      {
+        flushRunWord = w;
+        if (w != flushNextWord)
+        {
+#if LCD7920_ALPHA
+          if (flushingText)
+          {
+            // Lines 0 and 1 of the alpha RAM are at 0x00 and 0x10, lines 2 and 3 continue them at 0x08 and 0x18
+            queueCommand(LcdSetDdramAddress | ((flushRow & 1u) << 4) | ((flushRow & 2u) << 2) | w);
+          }
+          else
+#endif
+          {
+            queueGraphicsAddress(flushRow, w);
+          }
+          flushNextWord = w;
+          return true;
+        }
+      }
+      continue;
+    }
+
+#if LCD7920_ALPHA
+    if (flushingText)
+    {
+      // We have finished this line of text, so move on to the next line that has changed characters
+      ++flushRow;
+      while (flushRow < numTextLines && textDirty[flushRow] == 0)
+      {
+        ++flushRow;
+      }
+      if (flushRow < numTextLines)
+      {
+        if (!flushCsAsserted)
+        {
+          AssertCS();
+          flushCsAsserted = true;
+        }
+        flushRowDirty = textDirty[flushRow];
+        textDirty[flushRow] = 0;
+        flushNextWord = numTextCells;     // an invalid value, because we haven't set the address in this line
+        flushRunWord = 1;
+        flushRunEnd = 0;
+        if (!flushBasicMode)
+        {
+          queueCommand(LcdFunctionSetBasicAlpha);         // the alpha RAM can only be written using the basic instruction set
+          flushBasicMode = true;
+          return true;
+        }
+        continue;
+      }
+
+      // Now send the image
+      flushingText = false;
+      flushRow = 0xFF;
+      if (flushBasicMode)
+      {
+        queueCommand(LcdFunctionSetExtendedGraphic);      // graphics RAM addresses need the extended instruction set, and the display must be left using it
+        return true;
+      }
+      continue;
+    }
+#endif
+
+    // We have finished this row, so move on to the next row that has dirty words
+    ++flushRow;
+    while (flushRow < numRows)
+    {
+      const uint8_t r = flushRow;
+      uint8_t dirty = dirtyWords[r];
+#if LCD7920_SHADOW
+      if (dirty != 0)
+      {
+        dirty = removeUnchangedWords(r, dirty);
+        dirtyWords[r] = 0;
+      }
+#endif
+      if (dirty != 0)
+      {
+        if (!flushCsAsserted)
+        {
+          AssertCS();
+          flushCsAsserted = true;
+        }
+        dirtyWords[r] = 0;
+        flushRowDirty = dirty;
+        flushNextWord = numCols/16;       // an invalid value, because we haven't set the address in this row
+        flushRunWord = 1;
+        flushRunEnd = 0;
+        break;
+      }
+      ++flushRow;
+    }
+    if (flushRow >= numRows)
+    {
+      flushRow = numRows;                 // so that further calls don't wrap round
+      return false;
+    }
+  }
+}
+
+#if LCD7920_SHADOW
+
+// Return the hash of a word that we keep in the shadow in mode 1
+# if LCD7920_SHADOW == 1
+static inline uint8_t wordHash(const uint8_t *ptr)
+{
+  return ptr[0] ^ ((ptr[1] << 1) | (ptr[1] >> 7));    // rotating one byte means that changing any single pixel changes the hash
+}
+# endif
+
+// Given the dirty word mask for a row, clear the bits for words whose contents are the same as when we last sent them.
+// This doesn't record anything, because the image may change again before the flush gets to the word. recordSentWord() does that.
+uint8_t Lcd7920::removeUnchangedWords(uint8_t r, uint8_t dirty)
+{
+  if (!shadowValid)
+  {
+    return dirty;
+  }
+  const uint8_t *ptr = image + ((numCols/8) * r);
+  uint8_t mask = 1;
+  for (uint8_t w = 0; w < numCols/16; ++w, mask <<= 1, ptr += 2)
   {
-	  AssertCS();
-    uint8_t startColNum = startCol/16u;
-    uint8_t endColNum = (endCol + 15)/16u;
-    for (uint8_t r = startRow; r < endRow; ++r)
+    if (dirty & mask)
     {
-      setGraphicsAddress(r, startColNum);
-      const uint8_t *ptr = image + (((numCols/8) * r) + (2 * startColNum));
-      for (uint8_t i = startColNum; i < endColNum; ++i)
-      {      
-        sendLcdData(*ptr++);
-        //delayMicroseconds(LcdDataDelayMicros);
-		    sendLcdData(*ptr++);
-        delayMicroseconds(LcdDataDelayMicros);
+# if LCD7920_SHADOW == 1
+      if (shadow[((numCols/16) * r) + w] == wordHash(ptr))
+# else
+      const uint8_t * const s = shadow + ((numCols/8) * r) + (2 * w);
+      if (s[0] == ptr[0] && s[1] == ptr[1])
+# endif
+      {
+        dirty &= ~mask;
       }
     }
-    startRow = numRows;
-    startCol = numCols;
-    endCol = endRow = 0;
- 	  DeassertCS();
- }
+  }
+  return dirty;
+}
+
+// Record the contents of a word of the image as we queue it to be sent, so that the shadow always holds what the display holds
+void Lcd7920::recordSentWord(uint8_t r, uint8_t w, const uint8_t *ptr)
+{
+# if LCD7920_SHADOW == 1
+  shadow[((numCols/16) * r) + w] = wordHash(ptr);
+# else
+  uint8_t * const s = shadow + ((numCols/8) * r) + (2 * w);
+  s[0] = ptr[0];
+  s[1] = ptr[1];
+# endif
 }
 
+#endif
+
 // Set the cursor position
 void Lcd7920::setCursor(uint8_t r, uint8_t c)
 {
@@ -396,11 +831,8 @@ void Lcd7920::setPixel(uint8_t x, uint8_t y, PixelMode mode)
         break;
     }
     
-    // Change the dirty rectangle to account for a pixel being dirty (we assume it was changed)
-    if (startRow > y) { startRow = y; }
-    if (endRow <= y)  { endRow = y + 1; }
-    if (startCol > x) { startCol = x; }
-    if (endCol <= x)  { endCol = x + 1; }
+    // Flag the word containing the pixel as dirty (we assume it was changed)
+    dirtyWords[y] |= (1u << (x/16));
   }
 }
 
@@ -414,13 +846,56 @@ bool Lcd7920::readPixel(uint8_t x, uint8_t y) const
   return false;
 }
 
-// Set the address to write to. The column address is in 16-bit words, so it ranges from 0 to 7.
-void Lcd7920::setGraphicsAddress(unsigned int r, unsigned int c)
+// Queue the commands to set the address to write to. The column address is in 16-bit words, so it ranges from 0 to 7.
+void Lcd7920::queueGraphicsAddress(uint8_t r, uint8_t c)
+{
+    queue(0, 0xF8, LcdSetGdramAddress | (r & 31));
+    // don't seem to need a command delay between these two
+    queue(3, 0xF8, LcdSetGdramAddress | c | ((r & 32u) >> 2));
+    txLength = 6;
+    txPos = 0;
+    txDelay = LcdCommandDelayMicros;      // we definitely need this one
+}
+
+// Queue a single command
+void Lcd7920::queueCommand(uint8_t command)
+{
+    queue(0, 0xF8, command);
+    txLength = 3;
+    txPos = 0;
+    txDelay = LcdCommandDelayMicros;
+}
+
+// Queue a 16-bit word of image data, or a cell of 2 characters in alphanumeric mode
+void Lcd7920::queueData(const uint8_t *ptr)
+{
+    queue(0, 0xFA, ptr[0]);
+    queue(3, 0xFA, ptr[1]);
+    txLength = 6;
+    txPos = 0;
+    txDelay = LcdDataDelayMicros;
+}
+
+// Put a command or data byte into the transmit buffer at the specified offset, in the same form that sendLcd sends it
+void Lcd7920::queue(uint8_t offset, uint8_t data1, uint8_t data2)
 {
-    sendLcdCommand(LcdSetGdramAddress | (r & 31));
-    //commandDelay();  // don't seem to need this one
-    sendLcdCommand(LcdSetGdramAddress | c | ((r & 32u) >> 2));
-    commandDelay();    // we definitely need this one
+    txBuffer[offset] = data1;
+    txBuffer[offset + 1] = data2 & 0xF0;
+    txBuffer[offset + 2] = data2 << 4;
+}
+
+// Return true if we can write another byte to the SPI interface
+bool Lcd7920::spiReady()
+{
+  if (spiBusy)
+  {
+    if ((SPSR & (1u << SPIF)) == 0)
+    {
+      return false;
+    }
+    spiBusy = false;
+  }
+  return true;
 }
 
 void Lcd7920::commandDelay()
@@ -443,6 +918,7 @@ void Lcd7920::sendLcdData(uint8_t data)
 // Send a command to the lcd. Data1 is sent as-is, data2 is split into 2 bytes, high nibble first.
 void Lcd7920::sendLcd(uint8_t data1, uint8_t data2)
 {
+  bytesSent += 3;
   if (useSpi)
   {
     SPDR = data1;
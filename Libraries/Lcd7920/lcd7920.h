@@ -4,6 +4,24 @@
 
 #define PROGMEM_PTR			// nothing (used to flag that the pointer points to an object in PROGMEM)
 
+// LCD7920_SHADOW controls whether flush() remembers what it has sent, so that it can skip dirty words whose contents haven't changed.
+// This helps when the same text is redrawn repeatedly, at the cost of RAM:
+//  0 = don't remember anything, send every dirty word
+//  1 = remember an 8-bit hash of each word (512 bytes). A change to a single pixel always changes the hash,
+//      but about 1 in 256 larger changes to a word will leave it unchanged, so the word won't be updated until it changes again.
+//  2 = remember an exact copy of the display memory (1K, so only suitable for processors with more than 2K of RAM)
+#ifndef LCD7920_SHADOW
+# define LCD7920_SHADOW		(0)
+#endif
+
+// LCD7920_ALPHA controls whether the driver supports alphanumeric mode, in which text is drawn by the display using its built-in font.
+// This needs another 68 bytes of RAM for the text and which parts of it have changed, so it is off by default:
+//  0 = graphics mode only. begin() ignores its argument.
+//  1 = graphics or alphanumeric mode, chosen by the argument to begin()
+#ifndef LCD7920_ALPHA
+# define LCD7920_ALPHA		(0)
+#endif
+
 // Enumeration for specifying drawing modes
 enum PixelMode
 {
@@ -19,8 +37,9 @@ struct LcdFont
 	uint16_t startCharacter;    		// character code (e.g. ASCII) of the first character in the font
 	uint16_t endCharacter;      		// character code of the last character in the font
 	uint8_t height;            			// row height in pixels - only this number of pixels will be fetched and drawn - maximum 16 in this version of the software
-	uint8_t width;             			// max character width in pixels (the font table contains this number of bytes or words per character, plus 1 for the active width)  
+	uint8_t width;             			// max character width in pixels (the font table contains this number of bytes or words per character, plus 1 for the active width, in column-major fonts)
 	uint8_t numSpaces;					// number of space columns between characters before kerning
+	const PROGMEM_PTR uint16_t *index;	// nullptr for column-major fonts, else offset of each character for fonts in packed row-major format (see extras/convertfont.py)
 };
 
 // Class for driving 128x64 graphical LCD fitted with ST7920 controller
@@ -39,12 +58,17 @@ public:
   
   // Write a single character in the current font. Called by the 'print' functions. Works in both graphic and alphanumeric mode.
   // If in graphic mode, a call to setFont must have been made before calling this.
+  // In alphanumeric mode the character is drawn by the display using its built-in 8x16 font, so only characters 0x20 to 0x7E can be written.
   //  c = character to write
   // Returns the number of characters written (1 if we wrote it, 0 otherwise)
   virtual size_t write(uint8_t c);                 // write a character
 
-  // Initialize the display. Call this in setup(). Also call setFont to select initial text font.
-  void begin();
+  // Initialize the display. Call this in setup(). Also call setFont to select initial text font if using graphic mode.
+  //  gmode = true for graphic mode, in which text is drawn in the image buffer using the current font.
+  //          false for alphanumeric mode, in which text is sent to the display as character codes and drawn using its built-in font.
+  //          This gives 4 lines of 16 characters and needs far less data to be sent than graphic mode. It needs LCD7920_ALPHA set to 1.
+  // In both modes, anything drawn using setPixel, line, circle and bitmap is displayed on top of the text.
+  void begin(bool gmode = true);
   
   // Select the font to use for subsequent calls to write() in graphics mode. Must be called before calling write() in graphics mode.
   //  newFont = pointer to font descriptor in PROGMEM
@@ -59,6 +83,7 @@ public:
   // Set the cursor position
   //  r = row. This is the number of pixels from the top of the display to the top of the character.
   //  c = column. This is the number of pixels from the left hand edge of the display and the left hand edge of the character.
+  // In alphanumeric mode, the text goes on line r/16 starting at character position c/8.
   void setCursor(uint8_t r, uint8_t c);
   
   // Get the cursor column. Useful we have written some text.
@@ -67,12 +92,35 @@ public:
   // Set the right margin. In graphics mode, anything written will be truncated at the right margin. Defaults to the right hand edge of the display.
   void setRightMargin(uint8_t r);
   
-  // Clear a rectangle from the current position to the right margin (graphics mode only). The height of the rectangle is the height of the current font.
+  // Clear a rectangle from the current position to the right margin. The height of the rectangle is the height of the current font.
+  // In alphanumeric mode, fill the current line with spaces from the current position to the right margin.
   void clearToMargin();
   
   // Flush the display buffer to the display. In graphics mode, calls to write, setPixel, line and circle will not be committed to the display until this is called.
+  // Only the 16-pixel words of display memory that have been written since the last flush are sent.
+  // In alphanumeric mode, any characters that have changed since the last flush are also sent.
   void flush();
   
+  // Start flushing the display buffer to the display, without waiting for it to complete. Then call flushStep() until it returns false.
+  // Drawing is allowed while the flush is in progress. Anything drawn in a part of the display that has already been sent will be sent by the next flush.
+  // If a flush is already in progress then this does nothing.
+  void beginFlush();
+  
+  // Send as much of the flush started by beginFlush() as we can without waiting for the SPI interface or the display.
+  // Call this frequently, e.g. from loop() or from a scheduler task body. Returns true if the flush is still in progress.
+  bool flushStep();
+  
+  // Return true if a flush started by beginFlush() has not completed yet
+  bool isFlushing() const { return flushing; }
+  
+  // Set the function that flushStep() uses to time the delays that the display needs after each command.
+  // It must return a time in microseconds, and resolution is its resolution in microseconds. The default is micros() with a resolution of 4us.
+  // Use this if the sketch takes over timer 0, which stops micros() working.
+  void setTimeSource(uint16_t (*f)(), uint8_t resolution);
+  
+  // Get the number of bytes sent to the display by the last call to flush(). Each data or command byte for the display takes 3 bytes on the serial interface.
+  uint16_t getBytesSent() const { return bytesSent; }
+  
   // Set, clear or invert a pixel
   //  x = x-coordinate of the pixel, measured from left hand edge of the display
   //  y = y-coordinate of the pixel, measured down from the top of the display
@@ -110,12 +158,44 @@ private:
   bool useSpi;
   bool textInverted;
   bool justSetCursor;
+  bool flushing;                              // true if a flush is in progress
+  bool flushCsAsserted;                       // true if we have asserted CS during the current flush
+  bool spiBusy;                               // true if we have written SPDR and not yet seen the transfer complete
+  bool delayStarted;                          // true if we have started timing txDelay
+#if LCD7920_ALPHA
+  bool graphicsMode;                          // true if text is drawn in the image buffer, false if it is sent as character codes
+  bool flushingText;                          // true if the flush is still sending changed characters, which it does before the image
+  bool flushBasicMode;                        // true if the flush has switched the display to the basic instruction set to write characters
+#endif
   uint8_t clockPin, dataPin, csPin;
   uint16_t lastCharColData;                   // data for the last non-space column, used for kerning
   uint8_t row, column;
-  uint8_t startRow, startCol, endRow, endCol; // coordinates of the dirty rectangle
+  uint16_t bytesSent;                         // number of bytes sent by the last flush
+  uint8_t flushRow;                           // the pixel row that the flush is sending
+  uint8_t flushRowDirty;                      // the dirty words in flushRow that we haven't sent yet
+  uint8_t flushRunWord, flushRunEnd;          // the next word to send, and the last word, in the run of words we are sending
+  uint8_t flushNextWord;                      // the word that the display address points to
+  uint8_t txBuffer[6];                        // bytes waiting to be sent
+  uint8_t txLength, txPos;
+  uint8_t txDelay;                            // microseconds to wait after sending the bytes in txBuffer
+  uint16_t delayStart;                        // when we started timing txDelay
+  uint16_t (*timeSource)();                   // function that returns the time in microseconds
+  uint8_t timeResolution;                     // resolution of timeSource in microseconds
   uint8_t rightMargin;
   uint8_t image[(128 * 64)/8];                // image buffer, 1K in size (= half the RAM of the Uno)
+  uint8_t dirtyWords[64];                     // one byte per pixel row, with bit n set if 16-pixel word n of that row needs to be sent
+#if LCD7920_ALPHA
+  char text[4][16];                           // characters in alphanumeric mode, 4 lines of 16
+  uint8_t textDirty[4];                       // one byte per line of text, with bit n set if characters 2n and 2n+1 need to be sent
+#endif
+#if LCD7920_SHADOW
+  bool shadowValid;                           // false if the shadow doesn't reflect the display memory, e.g. after clear()
+# if LCD7920_SHADOW == 1
+  uint8_t shadow[(128 * 64)/16];              // hash of each word we last sent
+# else
+  uint8_t shadow[(128 * 64)/8];               // copy of what we last sent
+# endif
+#endif
   const struct LcdFont *currentFont;  		// pointer to descriptor for current font
   
   void AssertCS();
@@ -125,5 +205,20 @@ private:
   void sendLcd(uint8_t data1, uint8_t data2);
   void sendLcdSlow(uint8_t data);
   void commandDelay();
-  void setGraphicsAddress(unsigned int r, unsigned int c);
+  void queueGraphicsAddress(uint8_t r, uint8_t c);
+  void queueCommand(uint8_t command);
+  void queueData(const uint8_t *ptr);
+  void queue(uint8_t offset, uint8_t data1, uint8_t data2);
+  bool queueNextFlushUnit();
+  bool spiReady();
+  void markDirty(uint8_t r0, uint8_t r1, uint8_t c0, uint8_t c1);
+  void storeColumns(uint8_t c0, uint8_t c1, const uint8_t *rowBits, uint8_t nRows);
+  void writePacked(const PROGMEM_PTR uint8_t *glyph, uint8_t fontHeight);
+#if LCD7920_ALPHA
+  size_t writeText(uint8_t ch);
+#endif
+#if LCD7920_SHADOW
+  uint8_t removeUnchangedWords(uint8_t r, uint8_t dirty);
+  void recordSentWord(uint8_t r, uint8_t w, const uint8_t *ptr);
+#endif
 };
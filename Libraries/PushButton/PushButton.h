@@ -12,6 +12,17 @@ public:
   PushButton(int p) : pin(p) {}
   void init();
   void poll();
+  int getPin() const { return pin; }
+
+  // Set the state from a debounced reading made by the caller (e.g. InputScanner) instead of calling poll()
+  void setState(bool pressed)
+  {
+    if (pressed && !state)
+    {
+      newPress = true;
+    }
+    state = pressed;
+  }
 
   // Return the debounced state
   bool getState() 
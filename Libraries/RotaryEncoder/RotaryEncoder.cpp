@@ -1,10 +1,26 @@
 #include "RotaryEncoder.h"
 #include "arduino.h"
 
+// State transition table, indexed by (old state << 2) | new state. Each entry has the following meaning:
+// 0 - the encoder hasn't moved
+// 1 - the encoder has moved 1 unit clockwise
+// -1 = the encoder has moved 1 unit anticlockwise
+// 2 = illegal transition, we must have missed a state
+static const int8_t tbl[16] PROGMEM =
+{  0, +1, -1, 0,    // position 3 = 00 to 11, can't really do anything, so 0
+  -1,  0, -2, +1,   // position 2 = 01 to 10, assume it was a bounce and should be 01 -> 00 -> 10  
+  +1, +2,  0, -1,   // position 1 = 10 to 01, assume it was a bounce and should be 10 -> 00 -> 01
+   0, -1, +1, 0     // position 0 = 11 to 10, can't really do anything
+};
+
 void RotaryEncoder::init()
 {
   pinMode(pin0, INPUT_PULLUP);
   pinMode(pin1, INPUT_PULLUP);
+  pinReg0 = portInputRegister(digitalPinToPort(pin0));
+  pinReg1 = portInputRegister(digitalPinToPort(pin1));
+  mask0 = digitalPinToBitMask(pin0);
+  mask1 = digitalPinToBitMask(pin1);
   change = 0;
   delay(2);                  // ensure we read the initial state correctly
   state = readState();
@@ -12,32 +28,22 @@ void RotaryEncoder::init()
 
 void RotaryEncoder::poll()
 {
-  // State transition table. Each entry has the following meaning:
-  // 0 - the encoder hasn't moved
-  // 1 - the encoder has moved 1 unit clockwise
-  // -1 = the encoder has moved 1 unit anticlockwise
-  // 2 = illegal transition, we must have missed a state
-  static int tbl[16] = 
-  {  0, +1, -1, 0,    // position 3 = 00 to 11, can't really do anything, so 0
-    -1,  0, -2, +1,   // position 2 = 01 to 10, assume it was a bounce and should be 01 -> 00 -> 10  
-    +1, +2,  0, -1,   // position 1 = 10 to 01, assume it was a bounce and should be 10 -> 00 -> 01
-     0, -1, +1, 0     // position 0 = 11 to 10, can't really do anything
-  };
-  unsigned int t = readState();
-  int movement = tbl[(state << 2) | t];
+  update(readState());
+}
+
+// Update the position given the new state of the pins. If the encoder isn't using interrupts, this can be called from an ISR or the main program but not both.
+void RotaryEncoder::update(uint8_t newState)
+{
+  const int8_t movement = (int8_t)pgm_read_byte(&tbl[(state << 2) | newState]);
   if (movement != 0)
   {
     change += movement;
-    state = t; 
+    state = newState; 
   }
 }
 
-unsigned int RotaryEncoder::readState()
-{
-  return (digitalRead(pin0) ? 1u : 0u) | (digitalRead(pin1) ? 2u : 0u);
-}
-
-int RotaryEncoder::getChange()
+// Take the whole clicks from the accumulated change
+int RotaryEncoder::takeChange()
 {
   int r;
   noInterrupts();
@@ -58,4 +64,41 @@ int RotaryEncoder::getChange()
   return r;
 }
 
+int RotaryEncoder::getChange()
+{
+  const int r = takeChange();
+  if (r != 0)
+  {
+    clickTimeValid = false;    // these clicks weren't timed, so the next call to getAcceleratedChange() mustn't measure its interval from an earlier click
+  }
+  return r;
+}
+
+int RotaryEncoder::getAcceleratedChange(uint16_t now)
+{
+  const int r = takeChange();
+  const uint16_t interval = now - lastClickTime;
+  if (r == 0)
+  {
+    if (interval >= accelInterval)
+    {
+      clickTimeValid = false;  // the last click was long enough ago that the next one won't be accelerated, and we mustn't let the interval wrap round
+    }
+    return r;
+  }
+
+  uint8_t factor = 1;
+  if (clickTimeValid && maxAccel > 1)
+  {
+    const uint16_t perClick = interval/abs(r);
+    if (perClick < accelInterval)
+    {
+      factor = 1 + (uint8_t)(((uint32_t)(maxAccel - 1) * (accelInterval - perClick))/accelInterval);
+    }
+  }
+  lastClickTime = now;
+  clickTimeValid = true;
+  return r * factor;
+}
+
 // End
@@ -1,22 +1,56 @@
 #ifndef __RotaryEncoderIncluded
 #define __RotaryEncoderIncluded
 
+#include <stdint.h>
+
 class RotaryEncoder
 {
-  unsigned int state;
+  uint8_t state;
   int pin0, pin1;
   int ppc;
-  int change;
-
-  unsigned int readState();
+  volatile int change;
+  volatile uint8_t *pinReg0, *pinReg1;       // input registers for the two pins, so that we don't need to use digitalRead
+  uint8_t mask0, mask1;
+  uint8_t maxAccel;                          // largest acceleration factor, 1 = no acceleration
+  uint16_t accelInterval;                    // interval between clicks above which there is no acceleration
+  uint16_t lastClickTime;
+  bool clickTimeValid;
+  RotaryEncoder *nextInterruptEncoder;       // link to next encoder updated by the pin change interrupts
 
 public:
   RotaryEncoder(int p0, int p1, int pulsesPerClick) : 
-    state(0), pin0(p0), pin1(p1), ppc(pulsesPerClick), change(0) {}
+    state(0), pin0(p0), pin1(p1), ppc(pulsesPerClick), change(0), maxAccel(1), accelInterval(0), lastClickTime(0), clickTimeValid(false), nextInterruptEncoder(0) {}
 
   void init();
-  void poll();
-  int getChange();
+  void poll();                               // read the pins and update the position, call this every 1ms or so unless interrupts are enabled
+  void update(uint8_t newState);             // update the position from the pin states (bit 0 = pin0, bit 1 = pin1) read by the caller
+  int getChange();                           // return the number of clicks since the last call, clockwise positive
+  int getPin0() const { return pin0; }
+  int getPin1() const { return pin1; }
+
+  // Use the pin change interrupts to track the encoder instead of calling poll(). Both pins must support pin change interrupts.
+  // This is in RotaryEncoderIsr.cpp, so the pin change ISRs are only linked in if a sketch calls it.
+  bool enableInterrupt();
+
+  // Set up acceleration for getAcceleratedChange(). When clicks arrive faster than one per interval, each click counts as up to maxFactor clicks,
+  // in proportion to the speed. The interval is in whatever units the caller passes as the time to getAcceleratedChange().
+  void setAcceleration(uint8_t maxFactor, uint16_t interval)
+  {
+    maxAccel = maxFactor;
+    accelInterval = interval;
+  }
+
+  int getAcceleratedChange(uint16_t now);    // like getChange() but with acceleration, now is the current time (e.g. from millis())
+
+  static void pinChangeIsr();                // called by the pin change ISRs to update all encoders that use interrupts
+
+private:
+  int takeChange();
+
+  uint8_t readState() const
+  {
+    return ((*pinReg0 & mask0) ? 1u : 0u) | ((*pinReg1 & mask1) ? 2u : 0u);
+  }
 };
 
 #endif
@@ -0,0 +1,70 @@
+// Pin change interrupt support for RotaryEncoder.
+// This is a separate file so that the pin change ISRs only get linked in if the sketch calls RotaryEncoder::enableInterrupt().
+// Other libraries that use pin change interrupts (e.g. SoftwareSerial) can't be used in the same sketch if it does.
+// The pin change interrupts are specific to the AVR, so on other processors enableInterrupt() always fails and the sketch must call poll().
+
+#include "RotaryEncoder.h"
+#include "arduino.h"
+
+#ifdef __AVR__
+
+static RotaryEncoder *interruptEncoders = 0;   // list of encoders using the pin change interrupts
+
+bool RotaryEncoder::enableInterrupt()
+{
+  volatile uint8_t *pcicr0 = digitalPinToPCICR(pin0);
+  volatile uint8_t *pcicr1 = digitalPinToPCICR(pin1);
+  if (pcicr0 == 0 || pcicr1 == 0)
+  {
+    return false;                              // at least one of the pins doesn't support pin change interrupts
+  }
+
+  uint8_t oldSREG = SREG;
+  cli();
+  state = readState();
+  nextInterruptEncoder = interruptEncoders;
+  interruptEncoders = this;
+  *digitalPinToPCMSK(pin0) |= (1u << digitalPinToPCMSKbit(pin0));
+  *digitalPinToPCMSK(pin1) |= (1u << digitalPinToPCMSKbit(pin1));
+  *pcicr0 |= (1u << digitalPinToPCICRbit(pin0));
+  *pcicr1 |= (1u << digitalPinToPCICRbit(pin1));
+  SREG = oldSREG;
+  return true;
+}
+
+// Update all the encoders that use interrupts. We don't know which pin changed, so we read them all.
+void RotaryEncoder::pinChangeIsr()
+{
+  for (RotaryEncoder *e = interruptEncoders; e != 0; e = e->nextInterruptEncoder)
+  {
+    e->update(e->readState());
+  }
+}
+
+ISR(PCINT0_vect)
+{
+  RotaryEncoder::pinChangeIsr();
+}
+
+#ifdef PCINT1_vect
+ISR(PCINT1_vect, ISR_ALIASOF(PCINT0_vect));
+#endif
+
+#ifdef PCINT2_vect
+ISR(PCINT2_vect, ISR_ALIASOF(PCINT0_vect));
+#endif
+
+#ifdef PCINT3_vect
+ISR(PCINT3_vect, ISR_ALIASOF(PCINT0_vect));
+#endif
+
+#else
+
+bool RotaryEncoder::enableInterrupt()
+{
+  return false;
+}
+
+#endif
+
+// End
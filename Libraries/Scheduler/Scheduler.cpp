@@ -1,65 +1,84 @@
-#include "arduino.h"
 #include "Scheduler.h"
+#include "SchedulerHal.h"
 
-// Set USE_TIMER2 nonzero to use timer 2 as the scheduler tick source.
-// This alows us to generate a tick interval of just over 1ms whether using an 8MHz or 16MHz processor.
-// PWM using the Timer2 registers is still possible.
-// Set USE_TIMER2 zero to use timer1 as the tick source.
-// This requires patching wiring.c to allow us to intercept the tick interrupt.
-// The tick rate interval will be just over 1ms using a 16MHz clock, and just over 2ms using an 8MHz clock.
-#define USE_TIMER2    (1)
-
-#if USE_TIMER2
-
-// We set the prescaler to 64 for 10MHz clock and above, and to 32 for < 10MHz clock
-# if F_CPU >= 10000000
-#  define TCCR2_PRESCALER  (64)
-# else
-#  define TCCR2_PRESCALER  (32)
-# endif
-# define TICKS_PER_SECOND  ((F_CPU) / (256 * TCCR2_PRESCALER))
+#if SCHEDULER_TICKLESS
 
-#else
+// In tickless mode timer 2 runs from a prescaler of 1024, so we get the same tick rate as before by counting timer counts
+const uint8_t countsPerTick = (256 * TCCR2_PRESCALER)/1024;
+
+// The most ticks we wait before accounting for them, which must be less than one cycle of the 8-bit timer
+const uint8_t maxTicksAhead = 240/countsPerTick;
 
-// Wiring.c always uses a prescaler of 64 (timer 0 doesn't support 32)
-# define TICKS_PER_SECOND  ((F_CPU) / (256 * 64))
-extern void (*tick_callback)();    // this has to be patched in to wiring.c
+static uint8_t lastCount;             // the timer count at the last tick we accounted for
 
 #endif
 
 // Static data
-Task * volatile Task::rlr = 0;
+Task * volatile Task::rlr[Task::numPriorities] = { 0 };
+Task * volatile Task::rlt[Task::numPriorities] = { 0 };
+volatile uint8_t Task::readyMask = 0;
 Task * volatile Task::dlr = 0;
+Task * volatile Task::current = 0;
+volatile uint16_t Task::tickCount = 0;
+uint8_t *Task::stackLow = 0;
+#if SCHEDULER_LATENCY_STATS
+Task::LatencyStats Task::latencyStats[Task::numPriorities];
+#endif
+#if TASK_PROFILING
+Task *Task::allTasks = 0;
+Task::OverrunFunc Task::overrunFunc = 0;
+#endif
 
-Task::Task() : ticksToWakeup(-1), state(suspended), next(0) 
+#ifndef __AVR__
+HalHostSreg SREG(1u << SREG_I);
+void (*halHostInterruptHook)(bool enabled) = 0;
+uint8_t *halHostStackPointer = 0;
+uint8_t *halHostStackLimit = 0;
+volatile uint8_t halHostTimerCount = 0;
+volatile uint8_t halHostTimerCompare = 0;
+volatile bool halHostOverflowPending = false;
+#endif
+
+// Value we fill unused stack with
+static const uint8_t stackPaint = 0xC5;
+
+// Table of the highest bit set in a nibble, used to find the highest priority ready list that is not empty
+static const uint8_t highestBit[16] PROGMEM = { 0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3 };
+
+Task::Task(uint8_t pri) : ticksToWakeup(-1), state(suspended), notified(false), priority((pri < numPriorities) ? pri : numPriorities - 1), next(0), prev(0)
 {
+#if TASK_PROFILING
+  resetStats();
+  budget = 0;
+  name = 0;
+  nextTask = allTasks;
+  allTasks = this;
+#endif
 }
 
-#ifdef USE_TIMER2
+#ifdef __AVR__
+# if SCHEDULER_TICKLESS
+SIGNAL(TIMER2_COMPA_vect)
+{
+  Task::tick();
+}
+# elif USE_TIMER2
 SIGNAL(TIMER2_OVF_vect)
 {
   Task::tick();
 }
+# endif
 #endif
 
 void Task::init()
 {
   uint8_t oldSREG = SREG;
   cli();
-#if USE_TIMER2
-  TCCR2A |= 0x03;                      // fast PWM mode
-# if TCCR2_PRESCALER == 64
-  TCCR2B = (TCCR2B & 0xC0) | 0x04;     // set prescaler to 64
-# elif TCCR2_PRESCALER == 32
-  TCCR2B = (TCCR2B & 0xC0) | 0x03;     // set prescaler to 32
-# else
-#  error "Invalid value for TCCR2_PRESCALER"
-# endif
-  TIMSK2 = 0x01;                       // enable interrupt on overflow
-  ASSR = 0;                            // use internal clock
-#else
-  tick_callback = &Task::tick;
-#endif  
+  halInitTimer();
+#if SCHEDULER_TICKLESS
+  lastCount = halTimerCount();
+  setDeadline();
+#endif
   SREG = oldSREG;
 }
 
@@ -71,11 +90,268 @@ void Task::wakeup(int sleepTime)
   cli();
   if (state == suspended)
   {
+    if (sleepTime >= 0)
+    {
+      resumed(sleepTime);
+    }
     doWakeup(sleepTime);
   }
   SREG = oldSREG;
 }
 
+void Task::setPriority(uint8_t pri)
+{
+  if (pri >= numPriorities)
+  {
+    pri = numPriorities - 1;
+  }
+  uint8_t oldSREG = SREG;
+  cli();
+  if (state == ready)
+  {
+    // Move the task to the end of the ready list for its new priority
+    removeFromReadyList();
+    priority = pri;
+    addToReadyList();
+  }
+  else
+  {
+    priority = pri;
+  }
+  SREG = oldSREG;
+}
+
+uint16_t Task::getTickCount()
+{
+  uint8_t oldSREG = SREG;
+  cli();
+#if SCHEDULER_TICKLESS
+  catchUp();
+#endif
+  uint16_t rslt = tickCount;
+  SREG = oldSREG;
+  return rslt;
+}
+
+// Return the time in units of 1/256 of a tick, by combining the tick count with the timer count. Must be called with interrupts disabled.
+// The tick count is only 16 bits, so the result wraps round every 65536 ticks.
+uint32_t Task::timeNow()
+{
+#if SCHEDULER_TICKLESS
+  // There may be several whole ticks that we haven't accounted for yet
+  return ((uint32_t)tickCount << 8) + (uint16_t)(uint8_t)(halTimerCount() - lastCount) * (256/countsPerTick);
+#else
+  const uint8_t counts = halTimerCount();
+  uint16_t ticks = tickCount;
+  if (halTimerOverflowPending() && counts < 128)
+  {
+    ++ticks;                          // the timer has overflowed since we last processed a tick interrupt
+  }
+  return ((uint32_t)ticks << 8) | counts;
+#endif
+}
+
+#if SCHEDULER_LATENCY_STATS || TASK_PROFILING
+
+// Return the time from one value of timeNow() to a later one, saturating at 0xFFFF so that a long time doesn't look like a short one.
+// Times of 65536 ticks or more can't be told from shorter ones.
+uint16_t Task::timeBetween(uint32_t from, uint32_t to)
+{
+  const uint32_t elapsed = (to - from) & 0x00FFFFFFul;
+  return (elapsed > 0xFFFFu) ? 0xFFFFu : (uint16_t)elapsed;
+}
+
+#endif
+
+#if SCHEDULER_TICKLESS
+
+// Account for the whole ticks that have elapsed since we last did. This function may only be called with interrupts disabled.
+void Task::catchUp()
+{
+  const uint8_t ticks = (uint8_t)(halTimerCount() - lastCount)/countsPerTick;
+  if (ticks != 0)
+  {
+    lastCount += ticks * countsPerTick;
+    advanceTicks(ticks);
+  }
+}
+
+// Set the timer compare register so that we get an interrupt when the first task on the delay list is due.
+// If there isn't one, or it is a long way off, we still need an interrupt before the timer count wraps round.
+// This function may only be called with interrupts disabled.
+void Task::setDeadline()
+{
+  uint16_t counts = maxTicksAhead * countsPerTick;
+  if (dlr != 0 && dlr->ticksToWakeup < maxTicksAhead)
+  {
+    counts = dlr->ticksToWakeup * countsPerTick;
+  }
+  const uint8_t elapsed = halTimerCount() - lastCount;
+  if (counts < elapsed + 2u)
+  {
+    counts = elapsed + 2u;            // the deadline has passed or is about to, so make sure the compare value is still ahead of the timer
+  }
+  halSetTimerCompare(lastCount + (uint8_t)counts);
+}
+
+#endif
+
+#if SCHEDULER_LATENCY_STATS
+
+void Task::getLatencyStats(uint8_t pri, LatencyStats& stats)
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  stats = latencyStats[pri];
+  SREG = oldSREG;
+}
+
+void Task::resetLatencyStats()
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  memset(latencyStats, 0, sizeof(latencyStats));
+  SREG = oldSREG;
+}
+
+#endif
+
+#if TASK_PROFILING
+
+void Task::getStats(TaskStats& st) const
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  st = stats;
+  SREG = oldSREG;
+}
+
+void Task::resetStats()
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  memset(&stats, 0, sizeof(stats));
+  SREG = oldSREG;
+}
+
+// Record the statistics for one call of body(). This function may only be called with interrupts disabled.
+void Task::recordRun(uint16_t latency, uint16_t runTime, uint16_t stackUsed)
+{
+  if (stats.calls == 0xFFFF)
+  {
+    // Halve the count and total, to keep the average correct
+    stats.calls /= 2;
+    stats.totalTime /= 2;
+  }
+  ++stats.calls;
+  stats.totalTime += runTime;
+  if (runTime > stats.maxTime)
+  {
+    stats.maxTime = runTime;
+  }
+  if (latency > 256 && stats.lateCount != 0xFFFF)
+  {
+    ++stats.lateCount;
+  }
+  if (stackUsed > stats.maxStack)
+  {
+    stats.maxStack = stackUsed;
+  }
+}
+
+// Convert a time in 1/256ths of a tick to microseconds
+static uint32_t countsToMicros(uint32_t counts)
+{
+  return (counts * 1000000ul)/(256ul * TICKS_PER_SECOND);
+}
+
+// Print a table of the statistics for all tasks, with times in microseconds
+void Task::printStats(Print& p)
+{
+  p.println(F("Task\tPri\tCalls\tLate\tAvg us\tMax us\tBudget us\tStack"));
+  for (Task *t = allTasks; t != 0; t = t->nextTask)
+  {
+    TaskStats st;
+    t->getStats(st);
+    if (t->name != 0)
+    {
+      p.print(t->name);
+    }
+    else
+    {
+      p.print(F("0x"));
+      p.print((uintptr_t)t, HEX);
+    }
+    p.print('\t');
+    p.print(t->priority);
+    p.print('\t');
+    p.print(st.calls);
+    p.print('\t');
+    p.print(st.lateCount);
+    p.print('\t');
+    p.print(countsToMicros((st.calls == 0) ? 0 : st.totalTime/st.calls));
+    p.print('\t');
+    p.print(countsToMicros(st.maxTime));
+    p.print('\t');
+    p.print(countsToMicros(t->budget));
+    p.print('\t');
+    p.println(st.maxStack);
+  }
+  if (stackLow != 0)
+  {
+    p.print(F("Unused stack "));
+    p.println(getUnusedStack());
+  }
+}
+
+#endif
+
+// Put the task at the end of the ready list for its priority. This function may only be called with interrupts disabled.
+void Task::addToReadyList()
+{
+  state = ready;
+  next = (Task*)0;
+  prev = rlt[priority];
+  if (prev == 0)
+  {
+    rlr[priority] = this;
+    readyMask |= (1u << priority);
+  }
+  else
+  {
+    prev->next = this;
+  }
+  rlt[priority] = this;
+#if SCHEDULER_LATENCY_STATS || TASK_PROFILING
+  readyTime = timeNow();
+#endif
+}
+
+// Remove the task from the ready list for its priority. This function may only be called with interrupts disabled.
+void Task::removeFromReadyList()
+{
+  if (prev == 0)
+  {
+    rlr[priority] = next;
+    if (next == 0)
+    {
+      readyMask &= ~(1u << priority);
+    }
+  }
+  else
+  {
+    prev->next = next;
+  }
+  if (next == 0)
+  {
+    rlt[priority] = prev;
+  }
+  else
+  {
+    next->prev = prev;
+  }
+}
+
 // This function may only be called with interrupts disabled
 void Task::doWakeup(int sleepTime)
 {
@@ -83,90 +359,117 @@ void Task::doWakeup(int sleepTime)
   if (sleepTime == 0)
   {
     // Put task at end of ready list
-    state = ready;
     ticksToWakeup = 0;
-    Task** p = const_cast<Task**>(&rlr);
-    while (*p != 0)
-    {
-      p = const_cast<Task**>(&((*p)->next));
-    }
-    *p = this;
+    addToReadyList();
   }
   else if (sleepTime > 0)
   {
+#if SCHEDULER_TICKLESS
+    catchUp();                        // the delay list must be up to date before we work out where to insert the task
+#endif
     // Insert task into delay list
     state = delaying;
-    next = (Task*)0;
-    Task** p = const_cast<Task**>(&dlr);
-    while (*p != 0)
+    Task* p = 0;                      // the task we are to be inserted after
+    Task* t = dlr;                    // the task we are to be inserted before
+    while (t != 0)
     {
-      Task* t = *p;
       if (t->ticksToWakeup > sleepTime)
       {
         t->ticksToWakeup -= sleepTime;
-        next = t;
         break;
       }
       sleepTime -= t->ticksToWakeup;
-      p = const_cast<Task**>(&(t->next));
+      p = t;
+      t = t->next;
     }
     ticksToWakeup = sleepTime;
-    *p = this;
+    next = t;
+    prev = p;
+    if (t != 0)
+    {
+      t->prev = this;
+    }
+    if (p == 0)
+    {
+      dlr = this;
+#if SCHEDULER_TICKLESS
+      setDeadline();                  // we are now the first task due to wake up
+#endif
+    }
+    else
+    {
+      p->next = this;
+    }
   }
 }
 
 
 void Task::suspend()
 {
+  uint8_t oldSREG = SREG;
+  cli();                              // disable interrupts first, because the tick ISR may move us from the delay list to the ready list
   switch(state)
   {
   case suspended:
+  case running:                       // can't suspend current task
     break;
 
   case ready:
-    if (this != rlr)    // can't suspend current task
-    {
-      Task** p = const_cast<Task**>(&rlr);
-      uint8_t oldSREG = SREG;
-      cli();
-      while (*p != 0)
-      {
-        if (*p == this)
-        {
-          *p = next;
-          break;
-        }
-        p = const_cast<Task**>(&((*p)->next));
-      }
-      state = suspended;
-      SREG = oldSREG;
-    }
+    removeFromReadyList();
+    state = suspended;
     break;
 
   case delaying:
-    {
-      Task** p = const_cast<Task**>(&dlr);
-      uint8_t oldSREG = SREG;
-      cli();
-      while (*p != 0)
-      {
-        if (*p == this)
-        {
-          *p = const_cast<Task*>(next);
-          if (next != 0)
-          {
-            next->ticksToWakeup += ticksToWakeup;
-          }
-          break;
-        }
-        p = const_cast<Task**>(&((*p)->next));
-      }
-      state = suspended;
-      SREG = oldSREG;
-      ticksToWakeup = 0;
-    }
+    removeFromDelayList();
+    state = suspended;
+    ticksToWakeup = 0;
     break;
   }
+  SREG = oldSREG;
+}
+
+void Task::notify()
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  switch(state)
+  {
+  case suspended:
+    resumed(0);
+    doWakeup(0);
+    break;
+
+  case delaying:
+    removeFromDelayList();
+    doWakeup(0);
+    break;
+
+  case ready:
+    break;
+
+  case running:
+    notified = true;                  // loop() will make the task ready again when body() returns
+    break;
+  }
+  SREG = oldSREG;
+}
+
+// Remove the task from the delay list. This function may only be called with interrupts disabled.
+void Task::removeFromDelayList()
+{
+  if (next != 0)
+  {
+    next->ticksToWakeup += ticksToWakeup;
+    next->prev = prev;
+  }
+  if (prev == 0)
+  {
+    dlr = next;
+  }
+  else
+  {
+    prev->next = next;
+  }
 }
 
 // Suspend all tasks other than this one.
@@ -183,16 +486,18 @@ void Task::suspendOthers()
   }
   dlr = 0;
   
-  // Suspend all tasks on the ready list except the current one
-  t = rlr;
-  if (t != 0)
+  // Suspend all tasks on the ready lists. The current task isn't on any of them.
+  for (uint8_t pri = 0; pri < numPriorities; ++pri)
   {
-    while ((t = t->next) != 0)
+    t = rlr[pri];
+    while (t != 0)
     {
       t->state = suspended;
+      t = t->next;
     }
-    rlr->next = 0;
+    rlr[pri] = rlt[pri] = 0;
   }
+  readyMask = 0;
   SREG = oldSREG;
 }
 
@@ -200,54 +505,277 @@ void Task::loop()
 {
   uint8_t oldSREG = SREG;
   cli();
-  Task* current = rlr;
-  SREG = oldSREG;
-  if (current != 0)
+  const uint8_t mask = readyMask;
+  if (mask != 0)
   {
-    int t = current->body();
-    uint8_t oldSREG = SREG;
-    cli();
-    current->state = suspended;
-    rlr = current->next;
-    if (t >= 0)
+    // Take the first task from the highest priority ready list that is not empty
+    const uint8_t pri = (mask >= 0x10) ? 4 + pgm_read_byte(&highestBit[mask >> 4]) : pgm_read_byte(&highestBit[mask]);
+    Task* t = rlr[pri];
+    t->removeFromReadyList();
+    t->state = running;
+    current = t;
+#if TASK_PROFILING
+    uint8_t * const stackTop = halStackPointer();
+#endif
+#if SCHEDULER_LATENCY_STATS || TASK_PROFILING
+    const uint32_t startTime = timeNow();
+    const uint16_t latency = timeBetween(t->readyTime, startTime);
+#endif
+#if SCHEDULER_LATENCY_STATS
+    LatencyStats& stats = latencyStats[pri];
+    if (stats.count == 0xFFFF)
+    {
+      // Halve the count and total, to keep the average correct
+      stats.count /= 2;
+      stats.totalLatency /= 2;
+    }
+    ++stats.count;
+    stats.totalLatency += latency;
+    if (latency > stats.maxLatency)
     {
-      current->doWakeup(t);
+      stats.maxLatency = latency;
     }
+#endif
     SREG = oldSREG;
+
+#if TASK_PROFILING
+    // The stack is only used by this context and by ISRs, which have returned by the time we carry on, so we don't need to disable interrupts
+    // to paint or scan it. Any stack that an ISR uses while the task runs is counted as the task's.
+    if (stackLow != 0)
+    {
+      paintStackFrom(stackLow);       // repaint the stack that earlier tasks used, so that we can see how much this one uses
+    }
+#endif
+    int sleepTime = t->body();
+#if TASK_PROFILING
+    const uint16_t stackUsed = (stackLow != 0) ? stackTop - lowestStackUsedSinceRepaint() : 0;
+#endif
+    cli();
+    sleepTime = t->rearm(sleepTime);
+    if (t->notified)
+    {
+      t->notified = false;
+      sleepTime = 0;                  // something notified the task while it was running, so run it again as soon as possible
+    }
+#if TASK_PROFILING
+    const uint16_t runTime = timeBetween(startTime, timeNow());
+    t->recordRun(latency, runTime, stackUsed);
+#endif
+    current = 0;
+    t->state = suspended;
+    if (sleepTime >= 0)
+    {
+      t->doWakeup(sleepTime);
+    }
+#if TASK_PROFILING
+    if (t->budget != 0 && runTime > t->budget && overrunFunc != 0)
+    {
+      SREG = oldSREG;
+      overrunFunc(t, runTime);
+    }
+#endif
+  }
+#if SCHEDULER_TICKLESS
+  else if ((oldSREG & (1u << SREG_I)) != 0)
+  {
+    halIdle();                        // nothing is ready, so sleep until an interrupt makes a task ready
+  }
+#endif
+  SREG = oldSREG;
+}
+
+// An ISR only uses the stack below the stack pointer while it runs, so we don't need to disable interrupts while painting
+void Task::paintStack()
+{
+  paintStackFrom(halStackLimit());
+  stackLow = halStackPointer();
+}
+
+// Scanning all the free RAM takes a while, so we do it with interrupts enabled. Only loop() and this function change stackLow, and
+// neither is called from an ISR.
+uint16_t Task::getUnusedStack()
+{
+  uint16_t rslt = 0;
+  if (stackLow != 0)
+  {
+    uint8_t * const low = lowestStackUsed();
+    if (low < stackLow)
+    {
+      stackLow = low;
+    }
+    rslt = stackLow - halStackLimit();
+  }
+  return rslt;
+}
+
+// Paint the stack from the specified address up to the stack pointer. Everything below the stack pointer is free, including the part
+// below this function's own frame.
+void Task::paintStackFrom(uint8_t *from)
+{
+  uint8_t * const top = halStackPointer();
+  while (from < top)
+  {
+    *from++ = stackPaint;
+  }
+}
+
+// Return the lowest address on the stack that isn't still painted
+uint8_t *Task::lowestStackUsed()
+{
+  uint8_t *p = halStackLimit();
+  uint8_t * const top = halStackPointer();
+  while (p < top && *p == stackPaint)
+  {
+    ++p;
+  }
+  return p;
+}
+
+// Return the lowest address on the stack that isn't still painted, after loop() repainted the stack from stackLow up. Nothing below stackLow
+// has been used unless the byte just below it has, so usually we only need to scan up from stackLow, which takes no longer than the repaint.
+// Otherwise the stack has gone deeper than ever before, and we scan all the free RAM and lower stackLow.
+uint8_t *Task::lowestStackUsedSinceRepaint()
+{
+  uint8_t *p = stackLow;
+  if (p > halStackLimit() && p[-1] != stackPaint)
+  {
+    p = lowestStackUsed();
+    stackLow = p;
+    return p;
+  }
+  uint8_t * const top = halStackPointer();
+  while (p < top && *p == stackPaint)
+  {
+    ++p;
   }
+  return p;
 }
 
 // Tick ISR, must be called with interrupts already disabled
 void Task::tick()
 {
+#if SCHEDULER_TICKLESS
+  catchUp();
+  setDeadline();
+#else
+  advanceTicks(1);
+#endif
+}
+
+// Account for some ticks having elapsed, making ready any tasks that are due. This function may only be called with interrupts disabled.
+void Task::advanceTicks(uint8_t ticks)
+{
+  tickCount += ticks;
   Task* t = dlr;
+  while (t != 0 && t->ticksToWakeup <= ticks)
+  {
+    // Move this task from the front of the delay list to the end of the ready list for its priority
+    ticks -= t->ticksToWakeup;
+    dlr = t->next;
+    t->addToReadyList();
+    t = dlr;
+  }
   if (t != 0)
   {
-    --(t->ticksToWakeup);
-    if (t->ticksToWakeup == 0)
-    {
-      // Remove this task any any more with zero ticks to wakeup from the delay list
-      t->state = ready;
-      Task** tt = const_cast<Task**>(&(t->next));
-      while (*tt != 0 && (*tt)->ticksToWakeup == 0)
-      {
-        (*tt)->state = ready;
-        tt = const_cast<Task**>(&((*tt)->next));
-      }
-      dlr = *tt;
-      *tt = 0;
-      
-      // Append these tasks to the ready list
-      Task** pp = const_cast<Task**>(&rlr);
-      while (*pp != 0)
-      {
-        pp = const_cast<Task**>(&((*pp)->next));
-      }
-      *pp = t;
-    }
-  } 
+    t->ticksToWakeup -= ticks;
+    t->prev = 0;
+  }
 }
 
-// End
+// Start a new series of releases, the first one when the task is due to run. Called with interrupts disabled.
+void PeriodicTask::resumed(int sleepTime)
+{
+  nextRelease = getTickCount() + sleepTime;
+}
 
+// Return the number of ticks until the next release time, which must not have passed. This is limited to the largest sleep time wakeup()
+// accepts, because an int is only 16 bits on the AVR.
+int PeriodicTask::ticksUntilRelease(uint16_t now) const
+{
+  const uint16_t ticks = nextRelease - now;
+  return (ticks > 0x7FFFu) ? 0x7FFF : (int)ticks;
+}
 
+// Work out how long to sleep until the next release time. Called with interrupts disabled.
+int PeriodicTask::rearm(int sleepTime)
+{
+  if (sleepTime < 0)
+  {
+    return sleepTime;
+  }
+  const uint16_t now = getTickCount();
+  if ((int16_t)(now - nextRelease) < 0)
+  {
+    return ticksUntilRelease(now);    // notify() made us run before the release time, so keep waiting for it
+  }
+  nextRelease += period;
+  const uint16_t late = now - nextRelease;
+  if ((int16_t)late <= 0)
+  {
+    return ticksUntilRelease(now);
+  }
+
+  // We are already late for the next release. Run again now and skip any later releases that have also passed.
+  const uint16_t skipped = late/period;
+  nextRelease += skipped * period;
+  missedPeriods += skipped;
+  return 0;
+}
+
+uint16_t TaskQueueBase::getDropped() const
+{
+  uint8_t oldSREG = SREG;
+  cli();
+  const uint16_t rslt = dropped;
+  SREG = oldSREG;
+  return rslt;
+}
+
+bool TaskQueueBase::post(const void *msg)
+{
+  uint8_t oldSREG = SREG;
+  cli();                              // disable interrupts so that an ISR can't post a message between us choosing the slot and filling it
+  void *slot = startPost();
+  if (slot != 0)
+  {
+    memcpy(slot, msg, itemSize);
+    endPost();
+  }
+  SREG = oldSREG;
+  return slot != 0;
+}
+
+void *TaskQueueBase::startPost()
+{
+  const uint8_t a = added;
+  if ((uint8_t)(a - removed) > mask)
+  {
+    ++dropped;
+    return 0;
+  }
+  return buffer + (a & mask) * itemSize;
+}
+
+void TaskQueueBase::endPost()
+{
+  halMemoryBarrier();                 // make sure the message is in the buffer before the receiver can see it
+  added = added + 1;
+  if (receiver != 0)
+  {
+    receiver->notify();
+  }
+}
+
+void *TaskQueueBase::peek() const
+{
+  const uint8_t r = removed;
+  return (added == r) ? 0 : buffer + (r & mask) * itemSize;
+}
+
+void TaskQueueBase::remove()
+{
+  halMemoryBarrier();                 // make sure we have finished with the message before a producer can overwrite it
+  removed = removed + 1;
+}
+
+// End
@@ -1,18 +1,55 @@
 // Scheduler for Arduino
 
+#include <stdint.h>
+
+// Set SCHEDULER_LATENCY_STATS nonzero to record, for each priority, how long tasks wait between being made ready and starting to execute.
+// This adds 4 bytes of RAM to each task and 64 bytes of statistics, and some code to every wakeup and every run of a task.
+#ifndef SCHEDULER_LATENCY_STATS
+# define SCHEDULER_LATENCY_STATS  (0)
+#endif
+
+// Set SCHEDULER_TICKLESS nonzero to stop the scheduler interrupting every tick. Instead, timer 2 runs in normal mode and its compare match A
+// interrupt is set for when the first task on the delay list is due (or at most 15ms ahead), and the elapsed ticks are accounted for then.
+// loop() puts the processor in idle sleep mode when no task is ready, so it only wakes up when there is an interrupt.
+// In this mode timer 2 can't be used for PWM (pins 3 and 11 on the Uno and Nano). Timer 0 still interrupts every 1ms for millis() unless the sketch stops it.
+#ifndef SCHEDULER_TICKLESS
+# define SCHEDULER_TICKLESS  (0)
+#endif
+
+// Set TASK_PROFILING nonzero to record for each task how often it has run, how long its body() took, and how often it started late.
+// If Task::paintStack() has been called, it also records the most stack each task used.
+// This adds 22 bytes of RAM to each task, including the 4 that SCHEDULER_LATENCY_STATS also uses. Use Task::printStats() to print the results.
+#ifndef TASK_PROFILING
+# define TASK_PROFILING  (0)
+#endif
+
+#if TASK_PROFILING
+# include <Print.h>
+#endif
+
 class Task
 {
   enum TaskState
   {
     suspended = 0,
     ready = 1,
-    delaying = 2
+    delaying = 2,
+    running = 3
   };
 
+  friend class TaskChecker;                 // the host test harness in test/scheduler, which checks the lists
+
 public:
-  Task();	                            // build a new task but don't start it
+  // Tasks have a priority from 0 (lowest) to numPriorities - 1 (highest).
+  // loop() always runs the highest priority task that is ready. Tasks of equal priority run in the order they became ready.
+  static const uint8_t numPriorities = 8;
+
+  Task(uint8_t pri = 0);	            // build a new task with the specified priority but don't start it
   void suspend();			    // suspend the task (i.e. cancel any scheduled wakeup). If the task is already executing then the call is ignored.
+  void setPriority(uint8_t pri);            // change the priority of the task
+  uint8_t getPriority() const { return priority; }
   static void suspendOthers();              // suspend all other tasks except the current one
+  void notify();                            // make the task ready now, even if it is sleeping. If it is executing, it runs again when it returns. Safe to call from an ISR.
   
   // Test whether the task is suspended
   bool isSuspended() const {
@@ -23,7 +60,48 @@ public:
   static void init();
   static void tick();
 
+  static Task *getCurrent() { return current; }       // return the task whose body() is executing, or null if there isn't one
+  static uint16_t getTickCount();                    // return the number of ticks since init() was called, modulo 65536
+
+  // Fill the free RAM between the heap and the stack with a pattern, so that we can tell later how much of it has been used.
+  // Call this early in setup(), before the stack gets deep.
+  static void paintStack();
+  static uint16_t getUnusedStack();                  // return the least free RAM there has been between the heap and the stack since paintStack()
+
   static const unsigned int ticksPerSecond;
+
+#if SCHEDULER_LATENCY_STATS
+  struct LatencyStats
+  {
+    uint16_t count;                         // number of times a task of this priority has been started
+    uint16_t maxLatency;                    // longest time from being made ready to starting, in 1/256ths of a tick, or 0xFFFF if 256 ticks or more
+    uint32_t totalLatency;                  // total of the latencies, divide by count to get the average
+  };
+
+  static void getLatencyStats(uint8_t pri, LatencyStats& stats);   // get the latency statistics for a priority
+  static void resetLatencyStats();
+#endif
+
+#if TASK_PROFILING
+  // Times are in 1/256ths of a tick (4us with a 16MHz clock)
+  struct TaskStats
+  {
+    uint16_t calls;                         // number of times body() has been called
+    uint16_t lateCount;                     // number of times body() started more than a tick after the task was made ready
+    uint16_t maxTime;                       // longest execution time of body()
+    uint32_t totalTime;                     // total execution time of body()
+    uint16_t maxStack;                      // most stack used by body(), in bytes. Only recorded if paintStack() has been called.
+  };
+
+  typedef void (*OverrunFunc)(Task *t, uint16_t time);
+
+  void setName(const char *n) { name = n; }                       // give the task a name for printStats()
+  void setBudget(uint16_t b) { budget = b; }                      // set the longest time body() should take, or 0 for no limit
+  void getStats(TaskStats& stats) const;
+  void resetStats();
+  static void setOverrunCallback(OverrunFunc f) { overrunFunc = f; }  // set a function to call when body() takes longer than the budget
+  static void printStats(Print& p);                               // print the statistics for all tasks, e.g. to Serial
+#endif
   
 protected:
   void wakeup(int sleepTime);	            // wake up a task after the specified time. Safe to call from an ISR.
@@ -33,19 +111,71 @@ protected:
   // If it is zero then the task is placed at the back of the ready queue.
   // A negative number means we want to be suspended until another task wakes us up.
   virtual int body() = 0;
+
+  // This function is called with interrupts disabled after body() returns, to convert the value it returned into the sleep time.
+  // Derived classes can override it to schedule the next wakeup against something other than the time body() returned.
+  virtual int rearm(int sleepTime) { return sleepTime; }
+
+  // This function is called with interrupts disabled when wakeup() or notify() takes the task out of the suspended state, with the number of
+  // ticks until it will run. Derived classes can override it to restart anything they schedule against absolute times.
+  virtual void resumed(int sleepTime) { (void)sleepTime; }
   
 private:
 
   // internal function to wake up a task, must be called with interruopts disabled and task in suspended state
   void doWakeup(int sleepTime);	
 
+  // internal functions to add the task to the end of the ready list for its priority, and remove it. Must be called with interrupts disabled.
+  void addToReadyList();
+  void removeFromReadyList();
+
+  // internal function to remove the task from the delay list, must be called with interrupts disabled and task in delaying state
+  void removeFromDelayList();
+
+  static uint32_t timeNow();                // the time in 1/256ths of a tick modulo 2^24, must be called with interrupts disabled
+  static uint16_t timeBetween(uint32_t from, uint32_t to);  // the time from one timeNow() to a later one, or 0xFFFF if 256 ticks or more
+#if TASK_PROFILING
+  void recordRun(uint16_t latency, uint16_t runTime, uint16_t stackUsed);
+#endif
+  static void paintStackFrom(uint8_t *from);   // paint the stack from the specified address up to the stack pointer
+  static uint8_t *lowestStackUsed();        // return the lowest address that isn't still painted
+  static uint8_t *lowestStackUsedSinceRepaint();  // the same, but quicker when the stack hasn't gone deeper than stackLow
+  static void advanceTicks(uint8_t ticks);  // account for some ticks having elapsed, must be called with interrupts disabled
+#if SCHEDULER_TICKLESS
+  static void catchUp();                    // account for the whole ticks that have elapsed since we last did, must be called with interrupts disabled
+  static void setDeadline();                // set the timer compare for the next wakeup, must be called with interrupts disabled
+#endif
+
   int ticksToWakeup;		            // if this task is the first on on the delay list, then this is the number of ticks until it gets scheduled.
                                             // if it is not the first task on the delay list, need to add the tick counts from all other tasks ahead of it.
   volatile TaskState state;	            // what state the task is in
+  volatile bool notified;                   // true if notify() was called while the task was executing
+  uint8_t priority;
   Task * volatile next;		            // link to next task in list
+  Task * volatile prev;		            // link to previous task in list, so that we can remove a task without searching for it
+#if SCHEDULER_LATENCY_STATS || TASK_PROFILING
+  uint32_t readyTime;                       // when the task was last made ready, from timeNow()
+#endif
+#if TASK_PROFILING
+  TaskStats stats;
+  uint16_t budget;                          // longest time body() should take, 0 for no limit
+  const char *name;
+  Task *nextTask;                           // link to next task in the list of all tasks
+
+  static Task *allTasks;                    // list of all tasks that have been constructed
+  static OverrunFunc overrunFunc;
+#endif
 
-  static Task * volatile rlr;		    // ready list root
+  static Task * volatile rlr[numPriorities];	// ready list root for each priority
+  static Task * volatile rlt[numPriorities];	// ready list tail for each priority, so that we can append to a ready list without searching for the end
+  static volatile uint8_t readyMask;        // bit n is set if the ready list for priority n is not empty
   static Task * volatile dlr;	            // delay list root
+  static Task * volatile current;           // the task whose body() is executing
+  static volatile uint16_t tickCount;       // number of ticks since init(), modulo 65536
+  static uint8_t *stackLow;                 // the lowest stack address found to be used since paintStack() was called, or null
+#if SCHEDULER_LATENCY_STATS
+  static LatencyStats latencyStats[numPriorities];
+#endif
 };
 
 class SimpleTask : public Task
@@ -56,7 +186,7 @@ public:
   // A negative number means we want to be suspended until another task wakes us up.
   typedef int (*TaskFunc)();
 
-  SimpleTask(TaskFunc f) : Task(), func(f) {}	 // build a new SimpleTask but don't start it
+  SimpleTask(TaskFunc f, uint8_t pri = 0) : Task(pri), func(f) {}	 // build a new SimpleTask but don't start it
 
   void start(int sleepTime)
   {
@@ -73,5 +203,143 @@ private:
   TaskFunc func;
 };
 
+// A task that is released at regular intervals. The release times are kept as absolute tick counts, so unlike a task whose body()
+// returns the period, the rate doesn't drift by the execution time of body() or by the time the task spends waiting to run.
+// Derived classes implement body() as usual. If it returns a negative number then the task is suspended, otherwise the return value
+// is ignored and the task runs again at its next release time. If a release time has already passed when body() returns, the task
+// runs again immediately and any further release times that have passed are skipped and counted as missed periods.
+// When a suspended task is woken up by wakeup() or notify(), that starts a new series of releases. If notify() makes the task run before
+// its next release time, the task still runs again at that release time.
+class PeriodicTask : public Task
+{
+public:
+  // Build a new PeriodicTask but don't start it. The period is in ticks and must be between 1 and 32767.
+  PeriodicTask(uint16_t p, uint8_t pri = 0) : Task(pri), period(p), nextRelease(0), missedPeriods(0) {}
+
+  void start(int delay = 0) { wakeup(delay); }                   // release the task after the specified delay, then every period
+  void setPeriod(uint16_t p) { period = p; }                      // change the period, takes effect from the next release
+  uint16_t getPeriod() const { return period; }
+  uint16_t getMissedPeriods() const { return missedPeriods; }     // return the number of releases skipped because the task ran late
+  void resetMissedPeriods() { missedPeriods = 0; }
+
+protected:
+  /*override*/ int rearm(int sleepTime);
+  /*override*/ void resumed(int sleepTime);
+
+private:
+  int ticksUntilRelease(uint16_t now) const;
+
+  uint16_t period;
+  uint16_t nextRelease;                     // tick count at which the task was last released or will next be released
+  uint16_t missedPeriods;
+};
+
+// Protothread-style coroutine support. The body() of a task derived from CoroutineTask can be written as straight-line code
+// that gives up the processor part way through, using these macros:
+//   TASK_BEGIN();          must be the first statement in body()
+//   TASK_YIELD();          let other tasks that are ready run, then carry on from here
+//   TASK_SLEEP(n);         sleep for n ticks, then carry on from here
+//   TASK_WAIT_UNTIL(c);    carry on from here once condition c is true, testing it once per tick
+//   TASK_SUSPEND();        suspend the task until something calls wakeup() or notify(), then carry on from here
+//   TASK_END();            must be the last statement in body(). The task is suspended and starts again at TASK_BEGIN() when next woken up.
+// All coroutine tasks share the normal stack, so local variables of body() are lost each time one of these macros gives up the processor.
+// Use member variables for anything that must be kept. The macros can't be used inside a switch statement.
+class CoroutineTask : public Task
+{
+public:
+  CoroutineTask(uint8_t pri = 0) : Task(pri), resumeLine(0) {}	 // build a new CoroutineTask but don't start it
+
+  void start(int sleepTime)
+  {
+    wakeup(sleepTime);
+  }
+
+  // Make the task start again from TASK_BEGIN() next time it runs
+  void restart()
+  {
+    resumeLine = 0;
+  }
+
+protected:
+  uint16_t resumeLine;                      // source line of the macro that body() should carry on from, or 0 to start from the beginning
+};
+
+#define TASK_BEGIN()        switch (resumeLine) { case 0:
+#define TASK_SLEEP(n)       do { resumeLine = __LINE__; return (n); case __LINE__: ; } while (0)
+#define TASK_YIELD()        TASK_SLEEP(0)
+#define TASK_SUSPEND()      TASK_SLEEP(-1)
+#define TASK_WAIT_UNTIL(c)  do { resumeLine = __LINE__; case __LINE__: if (!(c)) { return 1; } } while (0)
+#define TASK_END()          } resumeLine = 0; return -1
+
+// Base class for TaskQueue, containing the code that doesn't depend on the message type
+class TaskQueueBase
+{
+public:
+  void setReceiver(Task *r) { receiver = r; }
+  uint8_t count() const { return added - removed; }              // return the number of messages waiting
+  bool isEmpty() const { return added == removed; }
+  uint16_t getDropped() const;                                    // return the number of messages discarded because the queue was full
+
+  void endPost();                                                 // add the message filled in after startPost() to the queue and notify the receiver
+  void remove();                                                  // discard the oldest message, after peek() has returned it
+
+protected:
+  TaskQueueBase(uint8_t *buf, uint16_t size, uint8_t capacity, Task *r)
+    : buffer(buf), itemSize(size), mask(capacity - 1), receiver(r), added(0), removed(0), dropped(0) {}
+
+  bool post(const void *msg);
+  void *startPost();
+  void *peek() const;
+
+private:
+  uint8_t * const buffer;
+  const uint16_t itemSize;
+  const uint8_t mask;
+  Task *receiver;
+  volatile uint8_t added;                   // number of messages posted, only changed by the producers
+  volatile uint8_t removed;                 // number of messages taken, only changed by the receiver
+  volatile uint16_t dropped;
+};
+
+// Fixed-capacity queue for passing messages of type T to a task, without using dynamic memory. T is copied with memcpy, so it should be a number
+// or a plain struct. N is the capacity and must be a power of 2 no greater than 128.
+// ISRs and tasks may post messages, but only the receiving task may take them. Posting a message calls notify() on the receiver, so the receiver's
+// body() normally takes all the messages waiting and then returns -1 to be suspended until the next one arrives.
+// To avoid copying large messages, a producer can call startPost(), fill in the message in place and call endPost(), and the receiver can call peek(),
+// use the message in place and then call remove(). Use startPost() and endPost() only if there is a single producer, or with interrupts disabled.
+template<class T, uint8_t N> class TaskQueue : public TaskQueueBase
+{
+public:
+  TaskQueue(Task *r = 0) : TaskQueueBase((uint8_t*)items, sizeof(T), N, r)
+  {
+    static_assert(N != 0 && N <= 128 && (N & (N - 1)) == 0, "TaskQueue capacity must be a power of 2 no greater than 128");
+  }
+
+  // Add a copy of a message to the queue. If the queue is full then the message is discarded and we return false. Safe to call from an ISR.
+  bool post(const T& msg) { return TaskQueueBase::post(&msg); }
+
+  // Return a pointer to the free slot that the next message should be written to, or null if the queue is full
+  T *startPost() { return (T*)TaskQueueBase::startPost(); }
+
+  // Take the oldest message. Returns false if the queue is empty.
+  bool get(T& msg)
+  {
+    const T *p = peek();
+    if (p == 0)
+    {
+      return false;
+    }
+    msg = *p;
+    remove();
+    return true;
+  }
+
+  // Return a pointer to the oldest message, or null if the queue is empty. The message stays valid until remove() is called.
+  T *peek() const { return (T*)TaskQueueBase::peek(); }
+
+private:
+  T items[N];
+};
+
 // End
 
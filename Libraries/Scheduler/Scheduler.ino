@@ -1,11 +1,11 @@
 // Demo function for task scheduler
-// This demo uses two intstances of SimpleTask to blink 2 LEDs at different rates.
-// A better approach (avoiding use of global variables) would be to derive a LED blink class from Task instead.
+// This demo blinks 2 LEDs at different rates. The first uses an instance of SimpleTask and a global variable.
+// The second uses a LED blink class derived from PeriodicTask, which avoids the global variable and keeps the blink rate
+// from drifting by the time the task takes to run.
 
 #include "Scheduler.h"
 
 bool ledState1 = false;
-bool ledState2 = false;
 
 // This task blinks a led on pin 13, 200ms on, 200ms off
 int myTaskFunc1()
@@ -15,17 +15,28 @@ int myTaskFunc1()
   return 200;
 }
 
-// This task blinks a led on pin 12, 500ms on, 500ms off
-int myTaskFunc2()
+// Class to blink a led with equal on and off times
+class Blinker : public PeriodicTask
 {
-  ledState2 = !ledState2;
-  digitalWrite(12, ledState2 ? HIGH : LOW);
-  return 500;
-}
-
-// Declare a SimpleTask to execute each task function
+public:
+  Blinker(uint8_t p, uint16_t onTime) : PeriodicTask(onTime), pin(p), ledState(false) {}
+
+protected:
+  /*override*/ int body()
+  {
+    ledState = !ledState;
+    digitalWrite(pin, ledState ? HIGH : LOW);
+    return 0;
+  }
+
+private:
+  uint8_t pin;
+  bool ledState;
+};
+
+// Declare a SimpleTask to execute the task function, and a Blinker for the led on pin 12, 500ms on, 500ms off
 SimpleTask myTask1(&myTaskFunc1);
-SimpleTask myTask2(&myTaskFunc2);
+Blinker myTask2(12, 500);
 
 void setup()
 {
@@ -0,0 +1,190 @@
+// Hardware abstraction for the task scheduler.
+// Scheduler.cpp only uses the hardware through the definitions in this file, so that it can also be compiled on a PC
+// to test the scheduling logic. This file must be included after Scheduler.h.
+
+#ifndef __SchedulerHal_Included
+#define __SchedulerHal_Included
+
+// Set USE_TIMER2 nonzero to use timer 2 as the scheduler tick source.
+// This alows us to generate a tick interval of just over 1ms whether using an 8MHz or 16MHz processor.
+// PWM using the Timer2 registers is still possible.
+// Set USE_TIMER2 zero to use timer1 as the tick source.
+// This requires patching wiring.c to allow us to intercept the tick interrupt.
+// The tick rate interval will be just over 1ms using a 16MHz clock, and just over 2ms using an 8MHz clock.
+#define USE_TIMER2    (1)
+
+#ifndef __AVR__
+# include <stdint.h>
+# include <string.h>
+# ifndef F_CPU
+#  define F_CPU  (16000000UL)              // the clock frequency we simulate on the host
+# endif
+#endif
+
+#if USE_TIMER2
+
+// We set the prescaler to 64 for 10MHz clock and above, and to 32 for < 10MHz clock
+# if F_CPU >= 10000000
+#  define TCCR2_PRESCALER  (64)
+# else
+#  define TCCR2_PRESCALER  (32)
+# endif
+# define TICKS_PER_SECOND  ((F_CPU) / (256 * TCCR2_PRESCALER))
+
+#else
+
+// Wiring.c always uses a prescaler of 64 (timer 0 doesn't support 32)
+# define TICKS_PER_SECOND  ((F_CPU) / (256 * 64))
+extern void (*tick_callback)();    // this has to be patched in to wiring.c
+
+#endif
+
+#if SCHEDULER_TICKLESS && !USE_TIMER2
+# error "SCHEDULER_TICKLESS requires USE_TIMER2"
+#endif
+
+// Stop the compiler moving memory accesses across this point, e.g. filling in a message after marking it as posted
+#define halMemoryBarrier()  __asm__ __volatile__("" ::: "memory")
+
+#ifdef __AVR__
+
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+// Critical sections use the usual AVR idiom of saving SREG, calling cli() and restoring SREG afterwards
+
+// Start the tick timer. Must be called with interrupts disabled.
+inline void halInitTimer()
+{
+#if SCHEDULER_TICKLESS
+  TCCR2A = 0;                          // normal mode, OC2A and OC2B disconnected
+  TCCR2B = 0x07;                       // set prescaler to 1024
+  ASSR = 0;                            // use internal clock
+  TIFR2 = (1u << OCF2A);               // clear any pending compare match
+  TIMSK2 = (1u << OCIE2A);             // enable interrupt on compare match A only
+#elif USE_TIMER2
+  TCCR2A |= 0x03;                      // fast PWM mode
+# if TCCR2_PRESCALER == 64
+  TCCR2B = (TCCR2B & 0xC0) | 0x04;     // set prescaler to 64
+# elif TCCR2_PRESCALER == 32
+  TCCR2B = (TCCR2B & 0xC0) | 0x03;     // set prescaler to 32
+# else
+#  error "Invalid value for TCCR2_PRESCALER"
+# endif
+  TIMSK2 = 0x01;                       // enable interrupt on overflow
+  ASSR = 0;                            // use internal clock
+#else
+  tick_callback = &Task::tick;
+#endif  
+}
+
+// Return the count of the timer that generates the ticks
+inline uint8_t halTimerCount()
+{
+#if USE_TIMER2
+  return TCNT2;
+#else
+  return TCNT0;
+#endif
+}
+
+// Return true if the tick timer has overflowed and the tick interrupt hasn't been serviced yet
+inline bool halTimerOverflowPending()
+{
+#if USE_TIMER2
+  return (TIFR2 & (1u << TOV2)) != 0;
+#else
+  return (TIFR0 & (1u << TOV0)) != 0;
+#endif
+}
+
+// Set the timer count at which we want the next interrupt (tickless mode only)
+inline void halSetTimerCompare(uint8_t count)
+{
+  OCR2A = count;
+}
+
+// Return the stack pointer
+inline uint8_t *halStackPointer()
+{
+  return (uint8_t*)SP;
+}
+
+// Return the lowest address the stack can grow down to without running into the heap
+inline uint8_t *halStackLimit()
+{
+  extern char __heap_start;
+  extern char *__brkval;
+  return (uint8_t*)((__brkval != 0) ? __brkval : &__heap_start);
+}
+
+// Sleep until the next interrupt. Must be called with interrupts disabled, and returns with them enabled.
+// The instruction after sei() is always executed before any pending interrupt is serviced, so an interrupt
+// that arrives after the caller disabled interrupts will wake us up.
+inline void halIdle()
+{
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_enable();
+  sei();
+  sleep_cpu();
+  sleep_disable();
+}
+
+#else
+
+// Host build, for testing the scheduler logic.
+// The critical section primitives just maintain the interrupt enable bit in a simulated SREG, so that a test harness can check that
+// interrupts are disabled where they should be. If the harness sets halHostInterruptHook, it is called whenever the interrupt enable
+// bit changes, so that it can time how long interrupts stay disabled. The harness simulates the tick timer by changing halHostTimerCount
+// and calling Task::tick() when the timer would overflow, or in tickless mode when it reaches halHostTimerCompare. To test the stack
+// measurement, it can point halHostStackLimit and halHostStackPointer into an array that stands for the free RAM.
+
+# define PROGMEM
+# define pgm_read_byte(p)  (*(const uint8_t *)(p))
+
+const uint8_t SREG_I = 7;
+extern void (*halHostInterruptHook)(bool enabled);
+
+class HalHostSreg
+{
+public:
+  HalHostSreg(uint8_t v) : value(v) { }
+  operator uint8_t() const { return value; }
+
+  HalHostSreg& operator=(uint8_t v)
+  {
+    const uint8_t changed = value ^ v;
+    value = v;
+    if ((changed & (1u << SREG_I)) != 0 && halHostInterruptHook != 0)
+    {
+      halHostInterruptHook((v & (1u << SREG_I)) != 0);
+    }
+    return *this;
+  }
+
+private:
+  volatile uint8_t value;
+};
+
+extern HalHostSreg SREG;
+extern uint8_t *halHostStackPointer;
+extern uint8_t *halHostStackLimit;
+extern volatile uint8_t halHostTimerCount;
+extern volatile uint8_t halHostTimerCompare;
+extern volatile bool halHostOverflowPending;
+
+inline void cli() { SREG = (uint8_t)(SREG & ~(1u << SREG_I)); }
+inline void sei() { SREG = (uint8_t)(SREG | (1u << SREG_I)); }
+inline void halInitTimer() { }
+inline uint8_t halTimerCount() { return halHostTimerCount; }
+inline bool halTimerOverflowPending() { return halHostOverflowPending; }
+inline void halSetTimerCompare(uint8_t count) { halHostTimerCompare = count; }
+inline void halIdle() { sei(); }      // nothing to wait for, the harness advances time between calls to Task::loop()
+inline uint8_t *halStackPointer() { return halHostStackPointer; }    // the harness can simulate a stack, otherwise these are null and
+inline uint8_t *halStackLimit() { return halHostStackLimit; }        // paintStack() does nothing
+
+#endif
+
+#endif
+
+// End
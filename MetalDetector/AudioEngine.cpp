@@ -0,0 +1,31 @@
+// Tone generation on timer 2 with pitch slewing and volume control
+
+#include "AudioEngine.h"
+
+void AudioEngine::init()
+{
+  TIMSK2 = 0;
+  TCCR2A = (1 << COM2B0) | (1 << COM2B1) | (1 << WGM21) | (1 << WGM20);   // set OC2B on compare match, clear OC2B at zero, fast PWM mode
+  TCCR2B = (1 << WGM22) | (1 << CS22) | (1 << CS21);                      // prescaler 256, allows frequencies from 246Hz upwards
+  OCR2A = 62;   // 1kHz tone
+  OCR2B = 255;  // greater than OCR2A, so no tone until update() sets it
+  targetDivisor = 0;
+  sounding = false;
+}
+
+void AudioEngine::setTone(uint16_t freq, uint8_t volume)
+{
+  if (freq == 0 || volume == 0)
+  {
+    targetDivisor = 0;
+  }
+  else
+  {
+    // Set the volume first, so that if the ISR sees the new divisor it also sees the new volume
+    targetVolume = (volume > MaxVolume) ? MaxVolume : volume;
+    const uint16_t f = (freq < MinFrequency) ? MinFrequency : (freq > MaxFrequency) ? MaxFrequency : freq;
+    targetDivisor = (uint8_t)(62500u/f);
+  }
+}
+
+// End
@@ -0,0 +1,74 @@
+#ifndef __AudioEngine_Included
+#define __AudioEngine_Included
+
+#include <stdint.h>
+#include <avr/io.h>
+
+// Tone generation for the earpiece or buzzer on OC2B, using timer 2.
+// loop() sets the target pitch and volume whenever it has a new result. The timer 1 ISR calls update() about once a millisecond, which slews
+// the pitch smoothly towards the target, so that the tone doesn't jump in steps at the rate that results arrive.
+// Timer 2 runs in fast PWM mode with TOP = OCR2A, so OCR2A sets the pitch, and OCR2B sets the duty cycle and hence the volume.
+class AudioEngine
+{
+public:
+  static const uint8_t MaxVolume = 8;           // volume 8 gives a 50% duty cycle, which is the loudest
+  static const uint16_t MinFrequency = 246;     // the lowest frequency with TOP below 255 at prescaler 256, so that OCR2B = 255 silences it
+  static const uint16_t MaxFrequency = 6000;
+  static const uint8_t SlewShift = 5;           // each update moves the pitch 1/2^SlewShift of the way to the target
+
+  AudioEngine() : targetDivisor(0), targetVolume(0), divisor(0), sounding(false) {}
+
+  // Set up timer 2. Call this with interrupts disabled.
+  void init();
+
+  // Set the tone to slew towards. A frequency or volume of zero silences the tone at the next update.
+  //  freq = frequency in Hz, which is constrained to MinFrequency to MaxFrequency
+  //  volume = 0 to MaxVolume
+  void setTone(uint16_t freq, uint8_t volume);
+
+  // Move the tone a step towards the target. Call this from the timer 1 ISR at a fixed rate.
+  // This takes a few tens of clocks, with no divisions and no loops.
+  void update()
+  {
+    const uint8_t target = targetDivisor;
+    if (target == 0)
+    {
+      OCR2B = 255;                      // greater than OCR2A, so the output stays low
+      sounding = false;
+      return;
+    }
+
+    // The divisor is held scaled by 2^7, so that the slew can make steps of less than one count
+    const uint16_t scaledTarget = (uint16_t)target << 7;
+    if (sounding)
+    {
+      divisor += (int16_t)(scaledTarget - divisor + (1u << (SlewShift - 1))) >> SlewShift;
+    }
+    else
+    {
+      divisor = scaledTarget;           // start a new tone at its target pitch, instead of sliding from the last one
+      sounding = true;
+    }
+    const uint8_t top = (uint8_t)((divisor + (1u << 6)) >> 7);
+    OCR2A = top;
+
+    // OC2B is high from OCR2B to TOP, for top * volume/16 counts rounded to nearest. At the highest pitches top is small enough for that
+    // to round to zero at volume 1, which would silence the tone, so we keep it at least 1.
+    uint8_t high = (uint8_t)(((uint16_t)top * targetVolume + 8u) >> 4);
+    if (high == 0)
+    {
+      high = 1;
+    }
+    OCR2B = top - high;
+  }
+
+private:
+  volatile uint8_t targetDivisor;       // 0 if the tone is off
+  volatile uint8_t targetVolume;
+  uint16_t divisor;                     // the current divisor scaled by 2^7, used only by update()
+  bool sounding;                        // used only by update()
+};
+
+#endif
+
+// End
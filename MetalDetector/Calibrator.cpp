@@ -0,0 +1,111 @@
+// Averaged calibration with noise measurement and drift tracking for the metal detector phase detectors
+
+#include "Calibrator.h"
+#include <string.h>
+
+// Integer square root, rounded down
+static uint16_t isqrt(uint32_t val)
+{
+  uint16_t root = 0;
+  for (uint16_t bit = 0x8000; bit != 0; bit >>= 1)
+  {
+    const uint16_t trial = root | bit;
+    if ((uint32_t)trial * trial <= val)
+    {
+      root = trial;
+    }
+  }
+  return root;
+}
+
+void Calibrator::clear()
+{
+  windowsLeft = 0;
+  calibrated = false;
+  noise = 0;
+  memset(offsets, 0, sizeof(offsets));
+}
+
+void Calibrator::start(uint8_t shift, uint8_t stride)
+{
+  windowsShift = (shift > MaxWindowsShift) ? MaxWindowsShift : shift;
+  windowsLeft = 1u << windowsShift;
+  strideShift = (stride > MaxStrideShift) ? MaxStrideShift : stride;
+  skipLeft = 0;
+  memset(sums, 0, sizeof(sums));
+  memset(sumSquares, 0, sizeof(sumSquares));
+}
+
+bool Calibrator::addResult(const int16_t result[4])
+{
+  if (windowsLeft == 0)
+  {
+    return false;
+  }
+  if (skipLeft != 0)
+  {
+    --skipLeft;
+    return false;
+  }
+  skipLeft = (1u << strideShift) - 1;
+
+  const uint8_t numWindows = 1u << windowsShift;
+  if (windowsLeft == numWindows)
+  {
+    memcpy(first, result, sizeof(first));
+  }
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    int16_t dev = result[i] - first[i];
+    if (dev > MaxDeviation)
+    {
+      dev = MaxDeviation;
+    }
+    else if (dev < -MaxDeviation)
+    {
+      dev = -MaxDeviation;
+    }
+    sums[i] += dev;
+    sumSquares[i] += (uint32_t)((int32_t)dev * dev);
+  }
+  --windowsLeft;
+  if (windowsLeft != 0)
+  {
+    return false;
+  }
+
+  // Set the offsets to the averages, and the noise to the RMS deviation from them averaged over the bins
+  uint32_t totalNoise = 0;
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    offsets[i] = ((int32_t)first[i] << DriftShift) + ((sums[i] << DriftShift) >> windowsShift);
+    const int32_t mean = sums[i] >> windowsShift;
+    const int32_t variance = (int32_t)(sumSquares[i] >> windowsShift) - mean * mean;
+    totalNoise += isqrt((variance < 0) ? 0 : (uint32_t)variance);
+  }
+  noise = (uint16_t)(totalNoise/4);
+  calibrated = true;
+  return true;
+}
+
+void Calibrator::apply(const int16_t result[4], int16_t out[4]) const
+{
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    out[i] = result[i] - getOffset(i);
+  }
+}
+
+void Calibrator::track(const int16_t result[4])
+{
+  if (!calibrated || windowsLeft != 0)
+  {
+    return;
+  }
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    offsets[i] += (int32_t)result[i] - (offsets[i] >> DriftShift);
+  }
+}
+
+// End
@@ -0,0 +1,59 @@
+#ifndef __Calibrator_Included
+#define __Calibrator_Included
+
+#include <stdint.h>
+
+// Calibration of the phase detector outputs. The coil is never perfectly balanced, so with no target present each of the 4 bins reads some
+// offset, which we measure and subtract from the filter outputs.
+// A calibration averages a number of filter outputs for each bin, and also measures the noise on each bin from the spread of the outputs.
+// The outputs it uses should be far enough apart that their noise is independent, otherwise both the offsets and the noise are less accurate.
+// Between calibrations, the offsets can track slow drift (e.g. from coil temperature changes or the ground) while no target is present.
+class Calibrator
+{
+public:
+  static const uint8_t MaxWindowsShift = 4;     // we average at most 2^MaxWindowsShift filter outputs in a calibration
+  static const uint8_t MaxStrideShift = 7;      // the most filter outputs apart that the ones we average can be, as a power of 2
+  static const uint8_t DriftShift = 10;         // drift tracking time constant, as a power of 2 number of filter outputs
+
+  Calibrator() : windowsShift(0), windowsLeft(0), strideShift(0), skipLeft(0), calibrated(false), noise(0) { clear(); }
+
+  // Discard any calibration, so that the offsets are all zero
+  void clear();
+
+  // Start a calibration that averages 2^shift filter outputs, using the next output and then one in every 2^stride outputs after it
+  void start(uint8_t shift, uint8_t stride = 0);
+  bool isCalibrating() const { return windowsLeft != 0; }
+  bool isCalibrated() const { return calibrated; }
+
+  // Feed a filter output into a calibration. Returns true if this completed the calibration.
+  bool addResult(const int16_t result[4]);
+
+  // Subtract the offsets from a filter output
+  void apply(const int16_t result[4], int16_t out[4]) const;
+
+  // Move the offsets a little way towards a filter output. Call this only for outputs where there is no target present.
+  void track(const int16_t result[4]);
+
+  int16_t getOffset(uint8_t bin) const { return (int16_t)((offsets[bin] + (1L << (DriftShift - 1))) >> DriftShift); }
+
+  // Return the RMS noise per bin measured during the last calibration, in the same units as the filter outputs
+  uint16_t getNoise() const { return noise; }
+
+private:
+  uint8_t windowsShift;
+  uint8_t windowsLeft;                  // number of filter outputs still needed to complete the calibration
+  uint8_t strideShift;
+  uint8_t skipLeft;                     // number of filter outputs to skip before we use the next one
+  bool calibrated;
+  uint16_t noise;
+  int16_t first[4];                     // first filter output of the calibration, which we measure the deviations of the others from
+  int32_t sums[4];                      // sums of the deviations from 'first'
+  uint32_t sumSquares[4];               // sums of the squared deviations from 'first'
+  int32_t offsets[4];                   // offsets scaled by 2^DriftShift, so that the drift tracking doesn't lose small changes
+
+  static const int16_t MaxDeviation = 4095;     // deviations are clamped to this so that the sums of squares can't overflow
+};
+
+#endif
+
+// End
@@ -0,0 +1,107 @@
+// Target classification by amplitude and phase, with notch reject/accept for each class
+
+#include "Classifier.h"
+#include <avr/pgmspace.h>
+
+// Classification table. We use the first row whose phase and amplitude are both at least the values in the row, so the rows must be in
+// decreasing order of phase, with any row that has a minimum amplitude before the rows it overrides.
+// When held in line with the centre of the coil:
+// - non-ferrous metals give a negative phase shift, e.g. -90deg for thick copper or aluminium, a copper olive, -30deg for thin aluminium.
+// - ferrous metals give zero phase shift or a small positive phase shift.
+// Small gold items give a phase shift between thin foil and the larger coins. These boundaries are starting points, to be adjusted
+// by experiment with the coil in use.
+// Coins are larger than the gold items we are looking for, so a weak signal at a coin's phase is more likely to be small gold than a coin.
+// The minimum amplitudes are relative to the threshold, so that they follow the sensitivity setting.
+struct ClassRange
+{
+  int16_t minPhase;                     // tenths of a degree
+  uint8_t minAmplitude;                 // in units of the threshold divided by AmplitudeRatioScale
+  uint8_t targetClass;
+};
+
+const uint8_t AmplitudeRatioScale = 4;
+
+static const ClassRange classTable[] PROGMEM =
+{
+  {  -200, 0,                          TargetIron },
+  {  -450, 0,                          TargetFoil },
+  {  -650, 0,                          TargetGold },
+  { -1800, 3 * AmplitudeRatioScale/2,  TargetCoin },     // at least 1.5 times the threshold
+  { -1800, 0,                          TargetGold }      // a weaker signal at a coin's phase
+};
+
+const uint8_t numClassRanges = sizeof(classTable)/sizeof(classTable[0]);
+
+TargetClass Classifier::classify(uint16_t amplitude, int16_t phase, uint16_t threshold, bool overloaded) const
+{
+  if (amplitude < threshold)
+  {
+    return TargetNone;
+  }
+  if (overloaded)
+  {
+    return TargetOverload;
+  }
+
+  // +180 degrees is the same as -180, which is the most negative phase shift. Without this, a phase just above +180 would be taken as iron.
+  while (phase >= 1800)
+  {
+    phase -= 3600;
+  }
+  while (phase < -1800)
+  {
+    phase += 3600;
+  }
+  const uint32_t scaledAmplitude = (uint32_t)amplitude * AmplitudeRatioScale;
+  for (uint8_t i = 0; i < numClassRanges; ++i)
+  {
+    if (phase >= (int16_t)pgm_read_word_near(&classTable[i].minPhase)
+        && scaledAmplitude >= (uint32_t)threshold * pgm_read_byte_near(&classTable[i].minAmplitude))
+    {
+      return (TargetClass)pgm_read_byte_near(&classTable[i].targetClass);
+    }
+  }
+  return TargetGold;                    // we never get here, because the last row covers everything from -180 degrees
+}
+
+void Classifier::setRejected(TargetClass c, bool reject)
+{
+  if (reject)
+  {
+    rejectMask |= (1u << c);
+  }
+  else
+  {
+    rejectMask &= ~(1u << c);
+  }
+}
+
+const char *Classifier::className(TargetClass c)
+{
+  switch (c)
+  {
+  case TargetNone:      return "None";
+  case TargetIron:      return "Iron";
+  case TargetFoil:      return "Foil";
+  case TargetGold:      return "Gold";
+  case TargetCoin:      return "Coin";
+  case TargetOverload:  return "Overload";
+  default:              return "?";
+  }
+}
+
+uint16_t Classifier::classTone(TargetClass c)
+{
+  // Low tones for the junk, higher ones for the targets worth digging
+  switch (c)
+  {
+  case TargetIron:      return 250;
+  case TargetFoil:      return 400;
+  case TargetGold:      return 700;
+  case TargetCoin:      return 1000;
+  case TargetOverload:  return 1500;
+  default:              return 0;
+  }
+}
+
+// End
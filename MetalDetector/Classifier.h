@@ -0,0 +1,52 @@
+#ifndef __Classifier_Included
+#define __Classifier_Included
+
+#include <stdint.h>
+
+// Target classes. The order doesn't matter to the classifier, but the notch menu steps through them in this order.
+enum TargetClass : uint8_t
+{
+  TargetNone = 0,           // amplitude below the threshold
+  TargetIron,
+  TargetFoil,
+  TargetGold,
+  TargetCoin,
+  TargetOverload,           // signal too strong to measure the phase reliably
+  NumTargetClasses
+};
+
+// Classification of a detector result by its amplitude and phase, using the table in Classifier.cpp.
+// Each class can be notched out (rejected), in which case the detector doesn't sound a tone for it.
+class Classifier
+{
+public:
+  Classifier() : rejectMask(0) {}
+
+  // Classify a result. Returns TargetNone if the amplitude is below the threshold, else TargetOverload if the result is overloaded.
+  //  amplitude = the amplitude, in the same units as the filter outputs
+  //  phase = the phase in tenths of a degree. Phases outside -1800 to +1799 are wrapped into that range.
+  //  threshold = the detection threshold, in the same units as the amplitude
+  //  overloaded = true if any of the filter outputs the result came from is at its limit, so that the phase is meaningless
+  TargetClass classify(uint16_t amplitude, int16_t phase, uint16_t threshold, bool overloaded) const;
+
+  // Notch a class out or back in
+  void setRejected(TargetClass c, bool reject);
+  bool isRejected(TargetClass c) const { return (rejectMask & (1u << c)) != 0; }
+
+  // Get or set the whole set of rejected classes, so that the sketch can save it in EEPROM
+  uint8_t getRejectMask() const { return rejectMask; }
+  void setRejectMask(uint8_t m) { rejectMask = m & ((1u << NumTargetClasses) - 1); }
+
+  // Return the name of a target class, for display
+  static const char *className(TargetClass c);
+
+  // Return the tone frequency in Hz for a target class with an amplitude just above the threshold
+  static uint16_t classTone(TargetClass c);
+
+private:
+  uint8_t rejectMask;                   // bit n set if class n is rejected
+};
+
+#endif
+
+// End
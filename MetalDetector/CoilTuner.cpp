@@ -0,0 +1,65 @@
+// Automatic tuning of the coil drive frequency by sweeping the timer 1 TOP value
+
+#include "CoilTuner.h"
+#include "Cordic.h"
+
+void CoilTuner::start(uint8_t first, uint8_t last)
+{
+  top = first;
+  lastTop = (last < first) ? first : last;
+  bestTop = first;
+  bestAmplitude = 0;
+  tuning = true;
+  startStep();
+}
+
+void CoilTuner::startStep()
+{
+  blocksLeft = SettleBlocks + (1u << MeasureBlocksShift);
+  sum = 0;
+}
+
+bool CoilTuner::addBlock(const int16_t block[4])
+{
+  if (!tuning)
+  {
+    return false;
+  }
+
+  --blocksLeft;
+  if (blocksLeft >= (1u << MeasureBlocksShift))
+  {
+    return false;                       // still settling
+  }
+
+  // Measure the amplitude the same way as the detector does, from both pairs of phase detectors
+  uint16_t amp1, amp2;
+  int16_t phase;
+  cordicToPolar(block[2], block[0], amp1, phase);
+  cordicToPolar(block[3], block[1], amp2, phase);
+  sum += ((uint32_t)amp1 + amp2)/2;
+  if (blocksLeft != 0)
+  {
+    return false;
+  }
+
+  const uint16_t amplitude = (uint16_t)(sum >> MeasureBlocksShift);
+  if (amplitude > bestAmplitude)
+  {
+    bestAmplitude = amplitude;
+    bestTop = top;
+  }
+  if (top == lastTop)
+  {
+    top = bestTop;
+    tuning = false;
+  }
+  else
+  {
+    ++top;
+    startStep();
+  }
+  return true;
+}
+
+// End
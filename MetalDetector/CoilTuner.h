@@ -0,0 +1,48 @@
+#ifndef __CoilTuner_Included
+#define __CoilTuner_Included
+
+#include <stdint.h>
+
+// Automatic tuning of the coil drive frequency.
+// The transmit coil and its tuning capacitor form a resonant circuit, and the signal induced in the receive coil is greatest when we drive it
+// at resonance. The tuner sweeps the timer 1 TOP value over a range, measures the average amplitude of the raw (uncalibrated) blocks at each
+// value, and finishes at the value that gave the highest amplitude.
+// The tuner doesn't touch the hardware. The caller reprograms timer 1 whenever addBlock() returns true.
+class CoilTuner
+{
+public:
+  static const uint8_t SettleBlocks = 2;         // blocks we ignore after each change of frequency, while the coil current settles
+  static const uint8_t MeasureBlocksShift = 4;   // we average 2^MeasureBlocksShift blocks at each frequency
+
+  CoilTuner() : top(0), lastTop(0), bestTop(0), blocksLeft(0), tuning(false), bestAmplitude(0), sum(0) {}
+
+  // Start a sweep of the TOP values from 'first' to 'last' inclusive. The caller must then set timer 1 TOP to getTop().
+  void start(uint8_t first, uint8_t last);
+  bool isTuning() const { return tuning; }
+
+  // Feed a block measured at the current TOP value into the sweep.
+  // Returns true if the caller must now set timer 1 TOP to getTop(), either because we have moved on to the next value or because the
+  // sweep has finished, in which case getTop() is the best value.
+  bool addBlock(const int16_t block[4]);
+
+  // Return the TOP value to measure at, or the best value once the sweep has finished
+  uint8_t getTop() const { return top; }
+
+  // Return the highest average amplitude seen during the sweep, in the same units as the blocks
+  uint16_t getBestAmplitude() const { return bestAmplitude; }
+
+private:
+  uint8_t top;
+  uint8_t lastTop;
+  uint8_t bestTop;
+  uint8_t blocksLeft;                   // number of blocks still to ignore or measure at this TOP value
+  bool tuning;
+  uint16_t bestAmplitude;
+  uint32_t sum;                         // sum of the amplitudes of the blocks measured so far at this TOP value
+
+  void startStep();
+};
+
+#endif
+
+// End
@@ -0,0 +1,59 @@
+// Integer CORDIC for the metal detector phase detectors
+
+#include "Cordic.h"
+#include <avr/pgmspace.h>
+
+// We scale the inputs up by this many bits so that rounding in the shifts doesn't limit the accuracy
+const uint8_t cordicScaleBits = 10;
+
+// atan(2^-i) in thousandths of a degree
+const uint8_t cordicIterations = 16;
+static const uint16_t cordicAngles[cordicIterations] PROGMEM =
+{
+  45000, 26565, 14036, 7125, 3576, 1790, 895, 448, 224, 112, 56, 28, 14, 7, 3, 2
+};
+
+// Reciprocal of the CORDIC gain (1.646760...), scaled by 2^16
+const uint32_t cordicInverseGain = 39797;
+
+void cordicToPolar(int16_t x, int16_t y, uint16_t& magnitude, int16_t& phase)
+{
+  int32_t xs = (int32_t)x << cordicScaleBits;
+  int32_t ys = (int32_t)y << cordicScaleBits;
+  int32_t angle = 0;                   // in thousandths of a degree
+
+  // The iterations only converge for angles between about -99 and +99 degrees, so rotate the vector by 180 degrees if it points left
+  if (xs < 0)
+  {
+    xs = -xs;
+    ys = -ys;
+    angle = (y < 0) ? -180000 : 180000;
+  }
+
+  // Rotate the vector onto the x axis, accumulating the angle we rotated it through
+  for (uint8_t i = 0; i < cordicIterations; ++i)
+  {
+    const int32_t dx = ys >> i;
+    const int32_t dy = xs >> i;
+    const uint16_t da = pgm_read_word_near(&cordicAngles[i]);
+    if (ys >= 0)
+    {
+      xs += dx;
+      ys -= dy;
+      angle += da;
+    }
+    else
+    {
+      xs -= dx;
+      ys += dy;
+      angle -= da;
+    }
+  }
+
+  // xs is now the magnitude multiplied by the CORDIC gain and by 2^cordicScaleBits.
+  // Remove the scaling first, so that multiplying by the reciprocal gain can't overflow.
+  magnitude = (uint16_t)(((((uint32_t)xs + (1u << (cordicScaleBits - 1))) >> cordicScaleBits) * cordicInverseGain + 0x8000u) >> 16);
+  phase = (int16_t)((angle >= 0) ? (angle + 50)/100 : -((50 - angle)/100));
+}
+
+// End
@@ -0,0 +1,20 @@
+#ifndef __Cordic_Included
+#define __Cordic_Included
+
+#include <stdint.h>
+
+// Integer CORDIC conversion from rectangular to polar form, used instead of sqrt and atan2 because the AVR has no FPU.
+// Accuracy over the whole input range:
+//  magnitude is within 1 count of sqrt(x*x + y*y)
+//  phase is within 1 (i.e. 0.1 degree) of atan2(y, x) expressed in tenths of a degree, for any non-zero vector
+// test/metaldetector/cordictest.cpp checks this against the C library.
+// A call is 16 iterations of 32-bit shifts and adds plus one multiplication, so on the AVR, which does floating point in software, it is
+// quicker than sqrt plus atan2. We haven't measured it on the target.
+//  x, y = components of the vector, each in the range -32767 to +32767
+//  magnitude = receives the length of the vector
+//  phase = receives the angle of the vector in tenths of a degree, in the range -1800 to +1800
+void cordicToPolar(int16_t x, int16_t y, uint16_t& magnitude, int16_t& phase);
+
+#endif
+
+// End
@@ -1,14 +1,43 @@
 #include <lcd7920.h>
 #include <RotaryEncoder.h>
 #include <PushButton.h>
+#include <InputScanner.h>
+#include <EEPROM.h>
+#include "Cordic.h"
+#include "WindowFilter.h"
+#include "Calibrator.h"
+#include "CoilTuner.h"
+#include "Classifier.h"
+#include "AudioEngine.h"
 
 #define DEBUG_OUTPUT  (0)
+#define ISR_PROFILING (0)         // set to 1 to measure how much of the sample period the timer 1 ISR uses (reported in the debug output)
+#define TELEMETRY     (0)         // set to 1 to send every result to the serial port as a binary frame, decode with extras/decodetelemetry.py
 
-extern const PROGMEM LcdFont font10x10; 
+// ADC acquisition modes
+#define ADC_MODE_8BIT         (0)  // read the top 8 bits of each conversion into 16-bit bins that saturate at +/-15000 (shortest ISR)
+#define ADC_MODE_10BIT        (1)  // read all 10 bits into 32-bit bins, which can't overflow within a block
+#define ADC_MODE_OVERSAMPLED  (2)  // as ADC_MODE_10BIT, but each block covers 4 times as many coil cycles, so there are fewer blocks with less noise
+
+#ifndef ADC_MODE
+# define ADC_MODE  ADC_MODE_8BIT   // the host simulation in test/metaldetector builds all three modes
+#endif
+
+#if DEBUG_OUTPUT && TELEMETRY
+# error "DEBUG_OUTPUT and TELEMETRY both use the serial port, so only one of them can be enabled"
+#endif
+
+#if TELEMETRY
+# include <util/crc16.h>
+#endif
+
+extern const PROGMEM LcdFont font10x10Packed;    // in glcd10x10packed.cpp
 
 // Induction balance metal detector
 
-// We run the CPU at 16MHz and the ADC clock at 1MHz. ADC resolution is reduced to 8 bits at this speed.
+// We run the CPU at 16MHz and the ADC clock at 1MHz. The ADC is only specified for full 10-bit accuracy at up to 200kHz, so by default
+// we only read 8 bits. The 10-bit modes still give lower quantisation noise, because the amplifier noise dithers the readings and
+// we add up many of them.
 
 // Timer 1 is used to divide the system clock by about 256 to produce a 62.5kHz square wave. 
 // This is used to drive timer 0 and also to trigger ADC conversions.
@@ -17,9 +46,10 @@ extern const PROGMEM LcdFont font10x10;
 // The ADC implements four phase-sensitive detectors at 45 degree intervals. Using 4 instead of just 2 allows us to cancel the third harmonic of the
 // coil frequency.
 
-// Timer 2 will be used to generate a tone for the earpiece or headset.
+// Timer 2 is used to generate a tone for the earpiece or headset. The timer 1 ISR updates its pitch and volume about once a millisecond.
 
-// Other division ratios for timer 1 are possible, from about 235 upwards.
+// Other division ratios for timer 1 are possible, from about 235 upwards. The ratio can be changed at run time from the Coil menu item,
+// either by hand or by the auto-tune sweep, and is saved in EEPROM along with the other settings.
 
 // Wiring:
 // Connect digital pin 4 (alias T0) to digital pin 9
@@ -27,7 +57,7 @@ extern const PROGMEM LcdFont font10x10;
 // Connect output from receive amplifier to analog pin 0. Output of receive amplifier should be biased to about half of the analog reference.
 // When using USB power, change analog reference to the 3.3V pin, because there is too much noise on the +5V rail to get good sensitivity.
 
-#define TIMER1_TOP  (244)         // can adjust this to fine-tune the frequency to get the coil tuned (see above)
+#define TIMER1_TOP  (244)         // default timer 1 TOP value, used until the coil has been tuned (see above)
 
 #define USE_3V3_AREF  (1)         // set to 1 if running on an Arduino with USB power, 0 for an embedded atmega328p with no 3.3V supply available
 
@@ -57,6 +87,8 @@ const int batteryVoltagePin = 1;
 const float BatteryVoltageRange = 3.3 * (100.0 + 47.0) / 47.0;   // the battery voltage that wold give a maximum ADC reading
 
 const int EncoderPulsesPerClick = 4;
+const uint8_t EncoderMaxAcceleration = 5;          // turning the encoder quickly changes the sensitivity by up to this many steps per click
+const uint16_t EncoderAccelerationTicks = 6250;    // clicks less than this many ticks (100ms) apart are accelerated
 
 // LCD rows
 const uint16_t row0 = 0;
@@ -66,43 +98,233 @@ const uint16_t row3 = 33;
 const uint16_t row4 = 44;
 const uint16_t row5 = 55;
 
+// Range of timer 1 TOP values. Below MinCoilTop there isn't time for an ADC conversion in each sample period. The profiling code
+// and the ISR budget assume that TOP fits in 8 bits.
+const uint8_t MinCoilTop = 235;
+const uint8_t MaxCoilTop = 255;
+
+// The settings are saved in EEPROM with a check byte, so that we can tell whether they have ever been saved.
+// Change SettingsVersion if you change this struct, so that settings saved by an older version of the sketch are ignored.
+const int SettingsEepromAddress = 0;
+const uint8_t SettingsVersion = 1;
+struct SavedSettings
+{
+  uint8_t coilTop;
+  uint8_t sensitivity;
+  uint8_t filterMode;
+  uint8_t blocksShift;
+  uint8_t rejectMask;
+  uint8_t volume;
+  uint8_t audioMode;
+  uint8_t check;                  // see settingsCheck()
+};
+
+#if ADC_MODE == ADC_MODE_8BIT
+typedef int16_t AdcBin;
+const uint8_t blockScaleShift = 0;        // how much loop() shifts the bins right to get the block values passed to the filter
+#else
+typedef int32_t AdcBin;
+const uint8_t blockScaleShift = (ADC_MODE == ADC_MODE_OVERSAMPLED) ? 4 : 2;   // 2 to scale 10-bit readings to 8 bits, plus 2 for 4 times as many coil cycles
+#endif
+
 // Variables used only by the ISR
-int16_t bins[4];                 // bins used to accumulate ADC readings, one for each of the 4 phases
+AdcBin bins[4];                  // bins used to accumulate ADC readings, one for each of the 4 phases
 uint16_t numSamples = 0;
-const uint16_t numSamplesToAverage = 1024;
+const uint16_t coilCyclesPerBlock = (ADC_MODE == ADC_MODE_OVERSAMPLED) ? 256 : 64;   // the ISR passes the bins to loop() after this many coil cycles.
+                                                                                     // The filter combines several blocks into a window.
 
 // Variables used by the ISR and outside it
-volatile int16_t averages[4];    // when we've accumulated enough readings in the bins, the ISR copies them to here and starts again
+// When we've accumulated a block of readings in the bins, the ISR copies them into the next free slot of this ring and starts again.
+// Only the ISR writes blocksWritten and only loop() writes blocksRead, so the ring needs no locking. Both counters are free-running.
+const uint8_t NumBlockBuffers = 8;   // must be a power of 2
+volatile AdcBin blockBuffers[NumBlockBuffers][4];
+volatile uint8_t blocksWritten = 0;  // number of blocks the ISR has put in the ring
+volatile uint8_t blocksRead = 0;     // number of blocks loop() has taken from the ring
 volatile uint16_t ticks = 0;     // system tick counter for timekeeping
 uint16_t whenButtonPressed;
 uint16_t LongPressTicks = 40000;
-volatile bool sampleReady = false;  // indicates that the averages array has been updated
 bool printCalibration = true;
-bool printSensitivity = true;
+bool printMenu = true;
 bool buttonDown = false;
+bool buttonTurned = false;       // true if the encoder has been turned since the button was pressed
 
 // Variables used only outside the ISR
-int16_t calib[4];                // values (set during calibration) that we subtract from the averages
+WindowFilter filter;             // combines the blocks from the ISR into windows
+int16_t averages[4];             // the most recent output from the filter
+Calibrator calibrator;           // measures the offsets that we subtract from the averages
+CoilTuner tuner;                 // sweeps the coil frequency to find the resonance
+Classifier classifier;           // decides what sort of target we have found
+AudioEngine audio;               // generates the tones
+bool displayPending = false;     // true if we have results that haven't been displayed yet
+
+const uint8_t CalibrationWindowsShift = 3;    // a calibration averages 2^CalibrationWindowsShift filter outputs
+
+// Results calculated from the most recent filter output
+int16_t calibrated[4];           // the averages adjusted for the calibration
+uint16_t amp1, amp2, ampAverage;
+int16_t phase1, phase2, phaseAverage;
+TargetClass targetClass = TargetNone;
+
+// Menu items that the encoder adjusts. Turning the encoder while holding the button down selects which item it adjusts.
+enum MenuItem : uint8_t
+{
+  MenuSensitivity = 0,
+  MenuFilterMode,
+  MenuFilterWindow,
+  MenuCoil,                      // pressing the button in this item starts the auto-tune sweep instead of a calibration
+  MenuNotch,                     // turning the encoder selects a target class, pressing the button rejects or accepts it
+  MenuVolume,
+  MenuAudioMode,
+  NumMenuItems
+};
+
+// How we sound the tone when we find a target that isn't rejected
+enum AudioMode : uint8_t
+{
+  AudioVco = 0,                  // each class starts at its own tone, and the pitch rises as the signal gets stronger
+  AudioId = 1,                   // each class has a fixed tone, and the volume rises as the signal gets stronger
+  AudioHum = 2,                  // as AudioVco, but with a quiet hum when there is no target, so that you can hear the detector is working
+  NumAudioModes = 3
+};
+
+AudioMode audioMode = AudioVco;
+uint8_t volume = AudioEngine::MaxVolume;
+const uint16_t HumFrequency = 250;
+const uint8_t HumVolume = 1;
+
+// The timer 1 ISR updates the audio once every AudioUpdateCoilCycles coil cycles, part way through the cycle so that it is never in the same
+// ISR call as the end of a block. This keeps the worst case ISR time the same as it was without the audio updates.
+const uint8_t AudioUpdateCoilCycles = 8;      // must be a power of 2. 8 coil cycles is about 1ms.
+const uint8_t AudioUpdatePhase = 3;           // the phase counter value at which we update the audio
+
+uint8_t menuItem = MenuSensitivity;
+TargetClass notchClass = TargetIron;   // the target class that the notch menu item is showing
 
 volatile uint8_t lastctr;
 volatile uint16_t misses = 0;    // this counts how many times the ISR has been executed too late. Should remain at zero if everything is working properly.
+volatile uint16_t blocksDropped = 0;    // this counts how many blocks the ISR discarded because the ring was full
+uint16_t blocksProcessed = 0;    // this counts how many blocks loop() has processed
+#if ISR_PROFILING
+volatile uint8_t isrMaxCycles = 0;      // the most CPU clocks from timer 1 overflow to the end of the ISR body since the last report
+volatile uint32_t isrTotalCycles = 0;   // the total of the same over all ISR calls since the last report
+uint16_t lastProfileTicks = 0;
+uint16_t lastProfileBlocks = 0;
+const uint8_t isrEpilogueClocks = 30;   // approximate number of clocks the ISR epilogue takes, which we can't measure
+#endif
 uint32_t lastPollTime = 0;
 const uint16_t PollInterval = 256; // Poll the button and the encoder every 256 ticks = every 4.096ms
 
-const double halfRoot2 = sqrt(0.5);
-const double quarterPi = 3.1415927/4.0;
-const double radiansToDegrees = 180.0/3.1415927;
+// The current timer 1 TOP value, and values that depend on it. setCoilTop() changes all of these.
+uint8_t coilTop = TIMER1_TOP;
+volatile uint8_t pendingCoilTop = 0;    // a new TOP value for the ISR to load at the end of the current coil cycle, or 0 if none
 
 // The ADC sample and hold occurs 2 ADC clocks (= 32 system clocks) after the timer 1 overflow flag is set.
-// This introduces a slight phase error, which we adjust for in the calculations.
-const float phaseAdjust = (float)((45.0 * 32.0)/(double)(TIMER1_TOP + 1));
+// This introduces a slight phase error, which we adjust for in the calculations. Phases are in tenths of a degree.
+int16_t phaseAdjust;
+
+// Time taken to accumulate one block, in microseconds
+uint16_t blockMicros;
+
+// Length of a tick in whole microseconds, rounded down so that the LCD driver's delays are never too short
+uint8_t microsPerTick;
+
+// Amplitudes are in the same units as the bins. We display them divided by this.
+const uint16_t ampDisplayDivisor = 200;
+
+int sensitivity = 5;              // lower = greater sensitivity. This is multipled by 5 * ampDisplayDivisor to get the threshold.
+uint16_t threshold;
 
-int sensitivity = 5;              // lower = greater sensitivity. This is multipled by 5 to get the threshold.
-float threshold;
+#if TELEMETRY
+const uint32_t TelemetryBaudRate = 250000;   // this divides 16MHz exactly, and is fast enough to send a frame for every block
+#endif
 
 Lcd7920 *lcd;
 RotaryEncoder *encoder;
 PushButton *button;
+InputScanner scanner;            // reads the button and encoder pins together
+
+// Return the tick counter. The ISR updates it, and it takes two loads to read it, so we read it with interrupts disabled.
+uint16_t readTicks()
+{
+  const uint8_t oldSREG = SREG;
+  cli();
+  const uint16_t t = ticks;
+  SREG = oldSREG;
+  return t;
+}
+
+// Return the time in microseconds, derived from the tick counter, for the LCD driver to time its delays.
+// Each tick is (coilTop + 1) clocks, which is between 14.75us and 16us.
+uint16_t tickMicros()
+{
+  return readTicks() * microsPerTick;
+}
+
+// Calculate the values that depend on the timer 1 TOP value
+void updateCoilTimings()
+{
+  phaseAdjust = (int16_t)((450u * 32u + (coilTop + 1u)/2)/(coilTop + 1u));
+  blockMicros = (uint16_t)(((uint32_t)coilCyclesPerBlock * 8u * (coilTop + 1u))/(F_CPU/1000000u));
+  microsPerTick = (uint8_t)((coilTop + 1u)/(F_CPU/1000000u));
+}
+
+// Return the coil drive frequency in Hz
+float coilFrequency()
+{
+  return (float)F_CPU/(8.0 * (coilTop + 1u));
+}
+
+// Return the check byte for a set of saved settings: the complement of the sum of the other bytes and the version number.
+// An erased EEPROM (all 0xFF) fails the check.
+uint8_t settingsCheck(const SavedSettings& saved)
+{
+  const uint8_t *p = (const uint8_t*)&saved;
+  uint8_t sum = SettingsVersion;
+  for (uint8_t i = 0; i < offsetof(SavedSettings, check); ++i)
+  {
+    sum += p[i];
+  }
+  return ~sum;
+}
+
+// Load the settings from EEPROM. If there aren't any valid ones, keep the defaults.
+// This must be called before timer 1 is set up, because it sets coilTop directly.
+void loadSettings()
+{
+  SavedSettings saved;
+  EEPROM.get(SettingsEepromAddress, saved);
+  if (   saved.check == settingsCheck(saved)
+      && saved.coilTop >= MinCoilTop && saved.coilTop <= MaxCoilTop
+      && saved.sensitivity >= 1 && saved.sensitivity <= 50
+      && saved.filterMode < NumFilterModes
+      && saved.blocksShift <= WindowFilter::MaxBlocksShift
+      && saved.volume <= AudioEngine::MaxVolume
+      && saved.audioMode < NumAudioModes
+     )
+  {
+    coilTop = saved.coilTop;
+    sensitivity = saved.sensitivity;
+    filter.setMode((FilterMode)saved.filterMode);
+    filter.setBlocksShift(saved.blocksShift);
+    classifier.setRejectMask(saved.rejectMask);
+    volume = saved.volume;
+    audioMode = (AudioMode)saved.audioMode;
+  }
+}
+
+void saveSettings()
+{
+  SavedSettings saved;
+  saved.coilTop = coilTop;
+  saved.sensitivity = (uint8_t)sensitivity;
+  saved.filterMode = filter.getMode();
+  saved.blocksShift = filter.getBlocksShift();
+  saved.rejectMask = classifier.getRejectMask();
+  saved.volume = volume;
+  saved.audioMode = audioMode;
+  saved.check = settingsCheck(saved);
+  EEPROM.put(SettingsEepromAddress, saved);    // put() only writes the bytes that have changed, so this doesn't wear the EEPROM needlessly
+}
 
 void setup()
 {
@@ -115,6 +337,9 @@ void setup()
   pinMode(coilDrivePin, OUTPUT);      // timer 0 output, square wave to drive transmit coil
   pinMode(LcdMosiPin, INPUT_PULLUP);
   pinMode(BuzzerPin, OUTPUT);
+
+  loadSettings();
+  updateCoilTimings();
   
   lcd = new Lcd7920(LcdSclkPin, LcdDataPin, LcdCsPin, false /*true*/);
   lcd->begin();
@@ -122,13 +347,16 @@ void setup()
   button->init();
   encoder = new RotaryEncoder(EncoderAPin, EncoderBPin, EncoderPulsesPerClick);
   encoder->init();
+  encoder->setAcceleration(EncoderMaxAcceleration, EncoderAccelerationTicks);
+  scanner.addButton(*button);
+  scanner.addEncoder(*encoder);
 
   // Read the battery voltage
   analogReference(EXTERNAL);
   const uint16_t reading = analogRead(batteryVoltagePin);
   float batteryVoltage = (BatteryVoltageRange/1024.0) * reading;
   
-  lcd->setFont(&font10x10);
+  lcd->setFont(&font10x10Packed);
   lcd->setRightMargin(128);
   lcd->setCursor(row0, 0);
   lcd->clear();
@@ -149,10 +377,12 @@ void setup()
   TIFR0 = 0x07;      // clear any pending interrupt
   
   // Set up ADC to trigger and read channel 0 on timer 1 overflow
+  // In 8-bit mode we left-adjust the result, so that the ISR only needs to read ADCH
+  const uint8_t adjust = (ADC_MODE == ADC_MODE_8BIT) ? (1 << ADLAR) : 0;
 #if USE_3V3_AREF
-  ADMUX = (1 << ADLAR);                   // use AREF pin (connected to 3.3V) as voltage reference, read pin A0, left-adjust result
+  ADMUX = adjust;                         // use AREF pin (connected to 3.3V) as voltage reference, read pin A0
 #else
-  ADMUX = (1 << REFS0) | (1 << ADLAR);    // use Avcc as voltage reference, read pin A0, left-adjust result
+  ADMUX = (1 << REFS0) | adjust;          // use Avcc as voltage reference, read pin A0
 #endif  
   ADCSRB = (1 << ADTS2) | (1 << ADTS1);   // auto-trigger ADC on timer/counter 1 overflow
   ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADPS2);  // enable adc, enable auto-trigger, prescaler = 16 (1MHz ADC clock)
@@ -163,10 +393,10 @@ void setup()
   TCCR1A = (1 << COM1A1) | (1 << WGM11);
   TCCR1B = (1 << WGM12) | (1 << WGM13) | (1 << CS10);    // CTC mode, prescaler = 1
   TCCR1C = 0;
-  OCR1AH = (TIMER1_TOP/2 >> 8);
-  OCR1AL = (TIMER1_TOP/2 & 0xFF);
-  ICR1H = (TIMER1_TOP >> 8);
-  ICR1L = (TIMER1_TOP & 0xFF);
+  OCR1AH = 0;
+  OCR1AL = coilTop/2;
+  ICR1H = 0;
+  ICR1L = coilTop;
   TCNT1H = 0;
   TCNT1L = 0;
   TIFR1 = 0x07;      // clear any pending interrupt
@@ -181,51 +411,99 @@ void setup()
   TCNT0 = 0;
 
   // Set up timer 2 for tone generation
-  TIMSK2 = 0;
-  TCCR2A = (1 << COM2B0) | (1 << COM2B1) | (1 << WGM21) | (1 << WGM20);   // set OC2B on compare match, clear OC2B at zero, fast PWM mode
-  TCCR2B = (1 << WGM22) | (1 << CS22) | (1 << CS21);                      // prescaler 256, allows frequencies from 245Hz upwards
-  OCR2A = 62;   // 1kHz tone
-  OCR2B = 255;  // greater than OCR2A to disable the tone for now. Set OCR2B = half OCR2A to generate a tone.
+  audio.init();
   
   sei();
 
-  while (!sampleReady) {}    // discard the first sample
+  lcd->setTimeSource(tickMicros, 16);    // micros() no longer works, so the LCD driver must use our tick counter to time its delays
+
+  while (blocksWritten == blocksRead) {}    // discard the first sample
+  blocksRead = blocksWritten;
   misses = 0;
-  sampleReady = false;
+  blocksDropped = 0;
 
 #if DEBUG_OUTPUT
   Serial.begin(19200);
 #endif
+#if TELEMETRY
+  Serial.begin(TelemetryBaudRate);
+#endif
 }
 
-void tone(unsigned int freq)
+// Wait for the timer 1 ISR to load a new TOP value. It does that at the end of the current coil cycle, so we wait at most 8 ticks.
+// The host simulation defines this before including the sketch, because there the ISR can't run while loop() waits.
+#ifndef WAIT_FOR_COIL_TOP
+# define WAIT_FOR_COIL_TOP()  while (pendingCoilTop != 0) {}
+#endif
+
+// Change the timer 1 TOP value, and so the coil drive frequency.
+// The calibration and the filter history were measured at the old frequency, so we discard them, along with any blocks waiting in the ring.
+void setCoilTop(uint8_t top)
 {
-  if (freq == 0)
-  {
-    OCR2B = 255;
-  }
-  else
+  // The LCD driver times its delays using microsPerTick, so finish any flush in progress before we change it
+  while (lcd->flushStep()) { }
+
+  // The ISR loads the new TOP value and restarts the block, so that no block mixes samples taken at two frequencies. We wait with
+  // interrupts enabled, so the other interrupts aren't held up.
+  pendingCoilTop = top;
+  WAIT_FOR_COIL_TOP();
+  coilTop = top;
+  updateCoilTimings();
+  blocksRead = blocksWritten;    // the ISR has restarted the block, so it can't write another one until a whole block time has passed
+
+  filter.reset();
+  calibrator.clear();
+  printCalibration = true;
+}
+
+// Start the auto-tune sweep. The result is saved in EEPROM when the sweep finishes.
+void startAutoTune()
+{
+  tuner.start(MinCoilTop, MaxCoilTop);
+  audio.setTone(0, 0);
+  setCoilTop(tuner.getTop());
+}
+
+// Start a calibration. We use only filter outputs that are far enough apart for their noise to be independent, otherwise
+// the average would be little better than a single output, and the noise we measure would be too low.
+void startCalibration()
+{
+  calibrator.start(CalibrationWindowsShift, filter.getIndependentShift());
+  printCalibration = true;
+}
+
+// Print a value that is in tenths, with one decimal place
+void printTenths(Print& p, int16_t val)
+{
+  if (val < 0)
   {
-    const uint8_t divisor = 62500u/constrain(freq, 245u, 6000);
-    OCR2A = divisor;
-    OCR2B = divisor/2;
+    p.write('-');
+    val = -val;
   }
+  p.print(val/10);
+  p.write('.');
+  p.write('0' + (val % 10));
 }
 
 // Timer 0 overflow interrupt. This serves 2 purposes:
 // 1. It clears the timer 0 overflow flag. If we don't do this, the ADC will not see any more Timer 0 overflows and we will not get any more conversions.
-// 2. It increments the tick counter, allowing is to do timekeeping. We get 62500 ticks/second.
+// 2. It increments the tick counter, allowing is to do timekeeping. We get F_CPU/(coilTop + 1) ticks/second, about 65300 with the default TOP.
 // We now read the ADC in the timer interrupt routine instead of having a separate conversion complete interrupt.
 ISR(TIMER1_OVF_vect)
 {
   uint8_t ctr = TCNT0;
+#if ADC_MODE == ADC_MODE_8BIT
   uint8_t val = ADCH;    // only need to read most significant 8 bits
+#else
+  uint16_t val = ADC;    // reads ADCL then ADCH
+#endif
   if (ctr != ((lastctr + 1) & 7))
   {
     ++misses;
   }
   lastctr = ctr;
-  int16_t *p = &bins[ctr & 3];
+  AdcBin *p = &bins[ctr & 3];
+#if ADC_MODE == ADC_MODE_8BIT
   if (ctr < 4)
   {
     int16_t temp = *p + (int16_t)val;
@@ -236,47 +514,200 @@ ISR(TIMER1_OVF_vect)
     int16_t temp = *p - (int16_t)val;
     *p = (temp < -15000) ? -15000 : temp;
   } 
+#else
+  // A bin can't exceed coilCyclesPerBlock * 1023 in magnitude, so it can't overflow and we don't need to clamp it
+  if (ctr < 4)
+  {
+    *p += val;
+  }
+  else
+  {
+    *p -= val;
+  }
+#endif
+  if (ctr == AudioUpdatePhase && (numSamples & (AudioUpdateCoilCycles - 1)) == 0)
+  {
+    audio.update();
+  }
   if (ctr == 7)
   {
-    ++numSamples;
-    if (numSamples == numSamplesToAverage)
+    const uint8_t newTop = pendingCoilTop;
+    if (newTop != 0)
     {
+      // Change the coil frequency and start a new block. ICR1 isn't double-buffered, so we must change it while timer 1 is below the new
+      // TOP value, or it would count all the way up to 0xFFFF before wrapping. It is, because we are early in the timer period.
+      OCR1AH = 0;
+      OCR1AL = newTop/2;
+      ICR1H = 0;
+      ICR1L = newTop;
+      pendingCoilTop = 0;
       numSamples = 0;
-      if (!sampleReady)      // if previous sample has been consumed
+      bins[0] = bins[1] = bins[2] = bins[3] = 0;
+    }
+    else if (++numSamples == coilCyclesPerBlock)
+    {
+      numSamples = 0;
+      const uint8_t written = blocksWritten;
+      if ((uint8_t)(written - blocksRead) < NumBlockBuffers)     // if there is a free slot in the ring
+      {
+        memcpy((void*)blockBuffers[written & (NumBlockBuffers - 1)], bins, sizeof(bins));
+        blocksWritten = written + 1;
+      }
+      else
       {
-        memcpy((void*)averages, bins, sizeof(averages));
-        sampleReady = true;
+        ++blocksDropped;
       }
       bins[0] = bins[1] = bins[2] = bins[3] = 0;
     }
   }
   ++ticks;
+#if ISR_PROFILING
+  // Timer 1 counts CPU clocks from 0 to coilTop starting at the overflow, so its count tells us how far into the sample period we are.
+  // This doesn't include the ISR epilogue, which adds about another 30 clocks. If the count exceeds coilTop then 'misses' will also increase.
+  const uint8_t cycles = TCNT1L;
+  if (cycles > isrMaxCycles)
+  {
+    isrMaxCycles = cycles;
+  }
+  isrTotalCycles += cycles;
+#endif
 }
 
-void loop()
+// Add a (possibly negative) change to a value, wrapping it into the range 0 to n-1
+uint8_t wrapAdd(uint8_t val, int change, uint8_t n)
 {
-  uint16_t localTicks;
-  do
+  int r = ((int)val + change) % (int)n;
+  return (r < 0) ? r + n : r;
+}
+
+// Adjust the selected menu item by the number of encoder clicks
+void adjustMenuItem(int change)
+{
+  switch (menuItem)
   {
-    localTicks = ticks;
-    if ((localTicks - lastPollTime) >= PollInterval)
+  case MenuSensitivity:
+    sensitivity = constrain(sensitivity + change, 1, 50);
+    break;
+
+  case MenuFilterMode:
+    filter.setMode((FilterMode)wrapAdd(filter.getMode(), change, NumFilterModes));
+    break;
+
+  case MenuFilterWindow:
+    filter.setBlocksShift(constrain((int)filter.getBlocksShift() + change, 0, (int)WindowFilter::MaxBlocksShift));
+    break;
+
+  case MenuCoil:
+    if (!tuner.isTuning())
     {
-      lastPollTime = localTicks;
-      encoder->poll();
-      button->poll();
+      setCoilTop(constrain((int)coilTop + change, (int)MinCoilTop, (int)MaxCoilTop));
     }
-  } while (!sampleReady);
-  
+    break;
+
+  case MenuNotch:
+    // Step through the classes other than TargetNone
+    notchClass = (TargetClass)(wrapAdd(notchClass - 1, change, NumTargetClasses - 1) + 1);
+    break;
+
+  case MenuVolume:
+    volume = constrain((int)volume + change, 0, (int)AudioEngine::MaxVolume);
+    break;
+
+  case MenuAudioMode:
+    audioMode = (AudioMode)wrapAdd(audioMode, change, NumAudioModes);
+    break;
+  }
+  printMenu = true;
+}
+
+// Return the name of an audio mode, for display
+const char *audioModeName(AudioMode m)
+{
+  switch (m)
+  {
+  case AudioVco:    return "VCO";
+  case AudioId:     return "ID";
+  case AudioHum:    return "VCO+hum";
+  default:          return "?";
+  }
+}
+
+// Display the selected menu item and its value
+void displayMenuItem()
+{
+  lcd->setCursor(row2, 0);
+  switch (menuItem)
+  {
+  case MenuSensitivity:
+    lcd->print("Sens ");
+    lcd->print(sensitivity);
+    break;
+
+  case MenuFilterMode:
+    lcd->print("Filter ");
+    lcd->print(WindowFilter::modeName(filter.getMode()));
+    break;
+
+  case MenuFilterWindow:
+    lcd->print("Window ");
+    lcd->print((unsigned int)((((uint32_t)blockMicros << filter.getBlocksShift()) + 500u)/1000u));
+    lcd->print("ms");
+    break;
+
+  case MenuCoil:
+    lcd->print(tuner.isTuning() ? "Tuning " : "Coil ");
+    lcd->print(coilTop);
+    lcd->write(' ');
+    lcd->print(coilFrequency()/1000.0, 2);
+    lcd->print("kHz");
+    break;
+
+  case MenuNotch:
+    lcd->print("Notch ");
+    lcd->print(Classifier::className(notchClass));
+    lcd->print(classifier.isRejected(notchClass) ? " reject" : " accept");
+    break;
+
+  case MenuVolume:
+    lcd->print("Volume ");
+    lcd->print(volume);
+    break;
+
+  case MenuAudioMode:
+    lcd->print("Audio ");
+    lcd->print(audioModeName(audioMode));
+    break;
+  }
+  lcd->clearToMargin();
+}
+
+// Check for button presses and encoder movement
+void checkControls(uint16_t localTicks)
+{
   if (button->getNewPress())
   {
     buttonDown = true;
+    buttonTurned = false;
     whenButtonPressed = localTicks;
   }
   else if (buttonDown)
   {
     if (button->getState())
     {
-      if (localTicks - whenButtonPressed >= LongPressTicks)
+      const int itemChange = encoder->getChange();
+      if (itemChange != 0)
+      {
+        // Encoder turned while the button is held down, so select a different menu item.
+        // Save any change made in the item we are leaving. While the tuner is running, coilTop isn't worth saving; the tuner saves its result.
+        if (!tuner.isTuning())
+        {
+          saveSettings();
+        }
+        menuItem = wrapAdd(menuItem, itemChange, NumMenuItems);
+        buttonTurned = true;
+        printMenu = true;
+      }
+      else if (!buttonTurned && localTicks - whenButtonPressed >= LongPressTicks)
       {
         // Button has been held down for long enough to indicate power down
         digitalWrite(PowerPin, false);
@@ -289,181 +720,277 @@ void loop()
     }
     else
     {
-      // Button pressed and released. We save the current phase detector outputs and subtract them from future results.
-      // This lets us use the detector if the coil is slightly off-balance.
-      // It would be better to average several samples instead of taking just one.
-      for (int i = 0; i < 4; ++i)
+      if (!buttonTurned)
       {
-        calib[i] = averages[i];
+        if (menuItem == MenuCoil)
+        {
+          // Button pressed and released in the coil item, so tune the coil. The coil should be well away from any metal while we do this.
+          if (!tuner.isTuning())
+          {
+            startAutoTune();
+            printMenu = true;
+          }
+        }
+        else if (menuItem == MenuNotch)
+        {
+          // Button pressed and released in the notch item, so toggle whether we reject the class it is showing
+          classifier.setRejected(notchClass, !classifier.isRejected(notchClass));
+          saveSettings();
+          printMenu = true;
+        }
+        else
+        {
+          // Button pressed and released. We average the next few phase detector outputs and subtract them from future results.
+          // This lets us use the detector if the coil is slightly off-balance.
+          startCalibration();
+        }
       }
-      sampleReady = false;
-      printCalibration = true;
       buttonDown = false;
     }
   }
   else
   {
-    const int sensChange = encoder->getChange();
-    if (sensChange != 0)
+    // Only the sensitivity has a wide enough range to need acceleration
+    const int change = (menuItem == MenuSensitivity) ? encoder->getAcceleratedChange(localTicks) : encoder->getChange();
+    if (change != 0)
     {
-      sensitivity = constrain(sensitivity + sensChange, 1, 50);
-      printSensitivity = true;
+      adjustMenuItem(change);
     }
   }
+}
 
-  if (printCalibration)
-  {
-    lcd->setCursor(row1, 0);
-    lcd->print("Cal");
-    for (int i = 0; i < 4; ++i)
-    {
-      lcd->write(' ');
-      lcd->print(calib[i]);
-    }
-    lcd->clearToMargin();
-    printCalibration = false;
-  }
+// Calculate the amplitudes and phases from the filter output, and sound the tone
+void processResult()
+{
+  // Adjust the results for the calibration
+  calibrator.apply(averages, calibrated);
+
+  cordicToPolar(calibrated[2], calibrated[0], amp1, phase1);
+  cordicToPolar(calibrated[3], calibrated[1], amp2, phase2);
+  ampAverage = (uint16_t)(((uint32_t)amp1 + amp2)/2);
+  phase1 += 450;
 
-  if (printSensitivity)
+  // If there is clearly no target present, let the calibration follow any slow drift
+  if (ampAverage < threshold/2)
   {
-    lcd->setCursor(row2, 0);
-    lcd->print("Sens ");
-    lcd->print(sensitivity);
-    lcd->clearToMargin();
-    threshold = 5 * sensitivity;
-    printSensitivity = false;
+    calibrator.track(averages);
   }
 
-  // Adjust the results for the calibration and divide by 200
-  const double f = 1.0/200.0;
-  double bin0 = (averages[0] - calib[0]) * f;
-  double bin1 = (averages[1] - calib[0]) * f;
-  double bin2 = (averages[2] - calib[0]) * f;
-  double bin3 = (averages[3] - calib[0]) * f;
-  sampleReady = false;          // we've finished reading the averages, so the ISR is free to overwrite them again
-
-  double amp1 = sqrt((bin0 * bin0) + (bin2 * bin2));
-  double amp2 = sqrt((bin1 * bin1) + (bin3 * bin3));
-  double ampAverage = (amp1 + amp2) * 0.5;
-  
-  double phase1 = atan2(bin0, bin2) * radiansToDegrees + 45.0;
-  double phase2 = atan2(bin1, bin3) * radiansToDegrees;
-
   if (phase1 > phase2)
   {
-    double temp = phase1;
+    const int16_t temp = phase1;
     phase1 = phase2;
     phase2 = temp;
   }
   
   // The ADC sample/hold takes place 2 clocks after the timer overflow
-  double phaseAverage = ((phase1 + phase2)/2.0) - phaseAdjust;
-  if (phase2 - phase1 > 180.0)
+  phaseAverage = ((phase1 + phase2)/2) - phaseAdjust;
+  if (phase2 - phase1 > 1800)
   { 
-    if (phaseAverage < 0.0)
+    if (phaseAverage < 0)
     {
-      phaseAverage += 180.0;
+      phaseAverage += 1800;
     }
     else
     {
-      phaseAverage -= 180.0;
+      phaseAverage -= 1800;
     }
   }
-      
-  // Display results on LCD
-  lcd->setCursor(row3, 0);
-  lcd->print(amp1, 1);
-  lcd->clearToMargin();
-  lcd->setCursor(row3, 32);
-  lcd->print(amp2, 1);
-  lcd->setCursor(row3, 64);
-  lcd->print((int)phase1);
-  lcd->setCursor(row3, 96);
-  lcd->print((int)phase2);
 
-  lcd->setCursor(row4, 0);
-  if (ampAverage >= threshold)
+  // phase1 can be up to 2250 after adding 45 degrees, so if the two phase detectors disagree the average can still be outside
+  // -180 to +180 degrees. Wrap it into -1800 to +1799, so that the display and the telemetry show the same phase that the classifier uses.
+  if (phaseAverage >= 1800)
+  {
+    phaseAverage -= 3600;
+  }
+  else if (phaseAverage < -1800)
+  {
+    phaseAverage += 3600;
+  }
+
+  // The filter clamps its outputs, so an output at the limit means the signal was too strong to measure. We check the outputs before
+  // the calibration, because subtracting the offsets can bring a clamped output back below the limit.
+  bool overloaded = false;
+  for (uint8_t i = 0; i < 4; ++i)
   {
-    // When held in line with the centre of the coil:
-    // - non-ferrous metals give a negative phase shift, e.g. -90deg for thick copper or aluminium, a copper olive, -30deg for thin alumimium.
-    // Ferrous metals give zero phase shift or a small positive phase shift.
-    // So we'll say that anything with a phase shift below -20deg is non-ferrous.
-    if (phaseAverage < -20.0)
+    if (averages[i] >= WindowFilter::MaxResult || averages[i] <= -WindowFilter::MaxResult)
     {
-      lcd->print("Non-ferrous");
+      overloaded = true;
+    }
+  }
+
+  targetClass = classifier.classify(ampAverage, phaseAverage, threshold, overloaded);
+
+  // Set the tone for every result, even if we don't have time to update the display for all of them
+  if (targetClass != TargetNone && !classifier.isRejected(targetClass))
+  {
+    if (audioMode == AudioId)
+    {
+      // Go up one volume step for every half threshold above the threshold
+      const uint16_t steps = 1 + (ampAverage - threshold)/(threshold/2);
+      audio.setTone(Classifier::classTone(targetClass), (steps < volume) ? steps : volume);
     }
     else
     {
-      lcd->print("Ferrous");
+      audio.setTone(Classifier::classTone(targetClass) + (ampAverage - threshold)/(ampDisplayDivisor/10), volume);
     }
-    tone(ampAverage * 10 + 245);
+  }
+  else if (audioMode == AudioHum)
+  {
+    audio.setTone(HumFrequency, (HumVolume < volume) ? HumVolume : volume);
   }
   else
   {
-    tone(0);
+    audio.setTone(0, 0);
+  }
+}
+
+// Display the most recent results on the LCD
+void displayResult()
+{
+  lcd->setCursor(row3, 0);
+  printTenths(*lcd, amp1/(ampDisplayDivisor/10));
+  lcd->clearToMargin();
+  lcd->setCursor(row3, 32);
+  printTenths(*lcd, amp2/(ampDisplayDivisor/10));
+  lcd->setCursor(row3, 64);
+  lcd->print(phase1/10);
+  lcd->setCursor(row3, 96);
+  lcd->print(phase2/10);
+
+  lcd->setCursor(row4, 0);
+  if (targetClass != TargetNone)
+  {
+    lcd->print(Classifier::className(targetClass));
+    if (classifier.isRejected(targetClass))
+    {
+      lcd->print(" (rejected)");
+    }
   }
   lcd->clearToMargin();
   lcd->setCursor(row5, 0);
-  float temp = ampAverage;
+  uint16_t temp = ampAverage;
   while (temp > threshold)
   {
     lcd->write('*');
     temp -= (threshold/2);
   }
   lcd->clearToMargin();
-  lcd->flush();
+}
+
+#if TELEMETRY
+
+// Binary telemetry frame, sent for each filter output. Multi-byte fields are little-endian.
+// The receiver finds the start of each frame from the sync bytes, then checks the length and the CRC.
+// If you change this, change extras/decodetelemetry.py to match.
+struct TelemetryFrame
+{
+  uint8_t sync[2];                // TelemetrySync0, TelemetrySync1
+  uint8_t length;                 // length of the whole frame, including the sync bytes and the CRC
+  uint8_t sequence;               // incremented for every frame, including ones we drop, so that the receiver can count dropped frames
+  uint16_t ticks;                 // the tick counter when we sent the frame (F_CPU/(coilTop + 1) ticks/second)
+  uint16_t misses;
+  uint16_t blocksDropped;
+  uint8_t coilTop;                // the timer 1 TOP value, which sets the length of a tick
+  int16_t averages[4];            // the filter output
+  int16_t offsets[4];             // the calibration offsets
+  uint16_t amp1, amp2, ampAverage;
+  int16_t phase1, phase2, phaseAverage;   // tenths of a degree
+  uint16_t crc;                   // CRC-16/XMODEM of the frame after the sync bytes and up to the CRC
+} __attribute__((packed));
+
+const uint8_t TelemetrySync0 = 0xA5;
+const uint8_t TelemetrySync1 = 0x5A;
+uint8_t telemetrySequence = 0;
+
+// Send the most recent results as a telemetry frame.
+// HardwareSerial sends from its transmit buffer under interrupt, so writing a frame only takes as long as copying it into the buffer.
+// If there isn't room in the buffer for the whole frame, we drop it rather than wait.
+void sendTelemetry(uint16_t localTicks)
+{
+  TelemetryFrame frame;
+  frame.sequence = telemetrySequence++;
+  if (Serial.availableForWrite() < (int)sizeof(frame))
+  {
+    return;
+  }
+
+  frame.sync[0] = TelemetrySync0;
+  frame.sync[1] = TelemetrySync1;
+  frame.length = sizeof(frame);
+  frame.ticks = localTicks;
+  frame.coilTop = coilTop;
+  cli();
+  frame.misses = misses;
+  frame.blocksDropped = blocksDropped;
+  sei();
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    frame.averages[i] = averages[i];
+    frame.offsets[i] = calibrator.getOffset(i);
+  }
+  frame.amp1 = amp1;
+  frame.amp2 = amp2;
+  frame.ampAverage = ampAverage;
+  frame.phase1 = phase1;
+  frame.phase2 = phase2;
+  frame.phaseAverage = phaseAverage;
+
+  const uint8_t *p = (const uint8_t*)&frame;
+  uint16_t crc = 0;
+  for (uint8_t i = 2; i < offsetof(TelemetryFrame, crc); ++i)
+  {
+    crc = _crc_xmodem_update(crc, p[i]);
+  }
+  frame.crc = crc;
+  Serial.write(p, sizeof(frame));
+}
+
+#endif
 
 #if DEBUG_OUTPUT
-  // For diagnostic purposes, print the individual bin counts and the 2 independently-calculated gains and phases
+
+// For diagnostic purposes, print the individual bin counts and the 2 independently-calculated gains and phases
+void printResult()
+{
   Serial.print(misses);
   Serial.write(' ');
   
-  if (bin0 >= 0.0) Serial.write(' ');
-  Serial.print(bin0, 2);
-  Serial.write(' ');
-  if (bin1 >= 0.0) Serial.write(' ');
-  Serial.print(bin1, 2);
-  Serial.write(' ');
-  if (bin2 >= 0.0) Serial.write(' ');
-  Serial.print(bin2, 2);
-  Serial.write(' ');
-  if (bin3 >= 0.0) Serial.write(' ');
-  Serial.print(bin3, 2);
-  Serial.print("    ");
-  Serial.print(amp1, 2);
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    if (calibrated[i] >= 0) Serial.write(' ');
+    Serial.print(calibrated[i]);
+    Serial.write(' ');
+  }
+  Serial.print("   ");
+  Serial.print(amp1);
   Serial.write(' ');
-  Serial.print(amp2, 2);
+  Serial.print(amp2);
   Serial.write(' ');
-  if (phase1 >= 0.0) Serial.write(' ');
-  Serial.print(phase1, 2);
+  if (phase1 >= 0) Serial.write(' ');
+  printTenths(Serial, phase1);
   Serial.write(' ');
-  if (phase2 >= 0.0) Serial.write(' ');
-  Serial.print(phase2, 2);
+  if (phase2 >= 0) Serial.write(' ');
+  printTenths(Serial, phase2);
   Serial.print("    ");
   
   // Print the final amplitude and phase, which we use to decide what (if anything) we have found)
-  if (ampAverage >= 0.0) Serial.write(' ');
-  Serial.print(ampAverage, 1);
   Serial.write(' ');
-  if (phaseAverage >= 0.0) Serial.write(' ');
-  Serial.print((int)phaseAverage);
+  Serial.print(ampAverage);
+  Serial.write(' ');
+  if (phaseAverage >= 0) Serial.write(' ');
+  Serial.print(phaseAverage/10);
   
   // Decide what we have found and tell the user
-  if (ampAverage >= threshold)
+  if (targetClass != TargetNone)
   {
-    // When held in line with the centre of the coil:
-    // - non-ferrous metals give a negative phase shift, e.g. -90deg for thick copper or aluminium, a copper olive, -30deg for thin alumimium.
-    // Ferrous metals give zero phase shift or a small positive phase shift.
-    // So we'll say that anything with a phase shift below -20deg is non-ferrous.
-    if (phaseAverage < -20.0)
+    Serial.write(' ');
+    Serial.print(Classifier::className(targetClass));
+    if (classifier.isRejected(targetClass))
     {
-      Serial.print(" Non-ferrous");
+      Serial.print(" (rejected)");
     }
-    else
-    {
-      Serial.print(" Ferrous");
-    }
-    float temp = ampAverage;
+    uint16_t temp = ampAverage;
     while (temp > threshold)
     {
       Serial.write('!');
@@ -471,5 +998,163 @@ void loop()
     }
   }   
   Serial.println();
+}
+
+# if ISR_PROFILING
+
+// Report the ISR cycle budget and the effective throughput about once per second
+void printProfile(uint16_t localTicks)
+{
+  if ((uint16_t)(localTicks - lastProfileTicks) >= 62500u)
+  {
+    cli();
+    const uint8_t maxCycles = isrMaxCycles;
+    const uint32_t totalCycles = isrTotalCycles;
+    const uint16_t dropped = blocksDropped;
+    isrMaxCycles = 0;
+    isrTotalCycles = 0;
+    sei();
+    const uint16_t elapsedTicks = localTicks - lastProfileTicks;
+    const uint16_t blocks = blocksProcessed - lastProfileBlocks;
+    lastProfileTicks = localTicks;
+    lastProfileBlocks = blocksProcessed;
+
+    // Each tick is one sample, and we process 8 samples per coil cycle for coilCyclesPerBlock coil cycles in each block
+    const float samplesPerSecond = (float)blocks * (8.0 * coilCyclesPerBlock) * ((float)F_CPU/(coilTop + 1u))/elapsedTicks;
+    Serial.print("ISR max ");
+    Serial.print(maxCycles);
+    Serial.print(" avg ");
+    Serial.print((float)totalCycles/elapsedTicks, 1);
+    Serial.print(" of ");
+    Serial.print(coilTop + 1u);
+    Serial.print(" clocks, dropped ");
+    Serial.print(dropped);
+    Serial.print(" blocks, ");
+    Serial.print(samplesPerSecond, 0);
+    Serial.print(" samples/s");
+    if (maxCycles + isrEpilogueClocks > coilTop + 1u)
+    {
+      Serial.print(" - ISR over budget, reduce ADC_MODE");
+    }
+    Serial.println();
+  }
+}
+
+# endif
+#endif
+
+// Convert the bins from the ISR to block values for the filter, in the units of the 8-bit mode. We do this here and not in the ISR
+// to keep the ISR short at the end of each block.
+void scaleBlock(const AdcBin rawBlock[4], int16_t block[4])
+{
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+#if ADC_MODE == ADC_MODE_8BIT
+    block[i] = rawBlock[i];
+#else
+    const int32_t val = (rawBlock[i] + (1L << (blockScaleShift - 1))) >> blockScaleShift;
+    block[i] = (val > 15000) ? 15000 : (val < -15000) ? -15000 : (int16_t)val;
+#endif
+  }
+}
+
+void loop()
+{
+  uint16_t localTicks;
+  do
+  {
+    localTicks = readTicks();
+    if ((localTicks - lastPollTime) >= PollInterval)
+    {
+      lastPollTime = localTicks;
+      scanner.scan();
+    }
+    lcd->flushStep();            // send some more of the display update, if there is one in progress
+  } while (blocksWritten == blocksRead);
+
+  // Take the oldest block from the ring. If loop() fell behind, for example while flushing the LCD, there will be more blocks waiting.
+  // We process all of them so that none are lost, but we only update the display once we have caught up.
+  AdcBin rawBlock[4];
+  const uint8_t read = blocksRead;
+  memcpy(rawBlock, (const void*)blockBuffers[read & (NumBlockBuffers - 1)], sizeof(rawBlock));
+  blocksRead = read + 1;       // we've finished reading the block, so the ISR is free to overwrite it again
+  int16_t block[4];
+  scaleBlock(rawBlock, block);
+  ++blocksProcessed;
+  bool newResult = false;
+  if (tuner.isTuning())
+  {
+    // While tuning, the blocks go to the tuner instead of the filter
+    if (tuner.addBlock(block))
+    {
+      setCoilTop(tuner.getTop());
+      if (!tuner.isTuning())
+      {
+        saveSettings();
+      }
+      printMenu = true;
+    }
+  }
+  else
+  {
+    newResult = filter.addBlock(block, averages);
+  }
+
+  checkControls(localTicks);
+
+  if (printCalibration)
+  {
+    lcd->setCursor(row1, 0);
+    if (calibrator.isCalibrating())
+    {
+      lcd->print("Calibrating");
+    }
+    else if (calibrator.isCalibrated())
+    {
+      lcd->print("Cal noise ");
+      printTenths(*lcd, calibrator.getNoise()/(ampDisplayDivisor/10));
+    }
+    else
+    {
+      lcd->print("Not calibrated");
+    }
+    lcd->clearToMargin();
+    printCalibration = false;
+    displayPending = true;
+  }
+
+  if (printMenu)
+  {
+    displayMenuItem();
+    threshold = 5 * ampDisplayDivisor * sensitivity;
+    printMenu = false;
+    displayPending = true;
+  }
+
+  if (newResult)
+  {
+    if (calibrator.addResult(averages))
+    {
+      printCalibration = true;     // we have just finished calibrating
+    }
+    processResult();
+    displayPending = true;
+#if DEBUG_OUTPUT
+    printResult();
+#endif
+#if TELEMETRY
+    sendTelemetry(localTicks);
+#endif
+  }
+
+  if (displayPending && blocksWritten == blocksRead && !lcd->isFlushing())
+  {
+    displayResult();
+    lcd->beginFlush();           // the rest of the flush happens while we wait for the next block
+    displayPending = false;
+  }
+
+#if DEBUG_OUTPUT && ISR_PROFILING
+  printProfile(localTicks);
 #endif
 }
@@ -0,0 +1,123 @@
+// Boxcar, sliding window and exponential filters for the metal detector phase detectors
+
+#include "WindowFilter.h"
+#include <string.h>
+
+void WindowFilter::setMode(FilterMode m)
+{
+  mode = m;
+  reset();
+}
+
+void WindowFilter::setBlocksShift(uint8_t shift)
+{
+  blocksShift = (shift > MaxBlocksShift) ? MaxBlocksShift : shift;
+  reset();
+}
+
+void WindowFilter::reset()
+{
+  blocksSeen = 0;
+  historyIndex = 0;
+  memset(state, 0, sizeof(state));
+  memset(history, 0, sizeof(history));
+}
+
+bool WindowFilter::addBlock(const int16_t block[4], int16_t result[4])
+{
+  const uint8_t numBlocks = 1u << blocksShift;
+  const uint8_t scaleShift = MaxBlocksShift - blocksShift;      // scale results up to the units of a window of MaxBlocks blocks
+  if (blocksSeen < numBlocks)
+  {
+    ++blocksSeen;
+  }
+
+  int32_t out[4];
+  switch (mode)
+  {
+  case FilterBoxcar:
+  default:
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+      state[i] += block[i];
+    }
+    if (blocksSeen < numBlocks)
+    {
+      return false;
+    }
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+      out[i] = state[i] << scaleShift;
+      state[i] = 0;
+    }
+    blocksSeen = 0;
+    break;
+
+  case FilterSliding:
+    {
+      int16_t *oldest = history[historyIndex];
+      for (uint8_t i = 0; i < 4; ++i)
+      {
+        state[i] += block[i] - oldest[i];
+        oldest[i] = block[i];
+        out[i] = state[i] << scaleShift;
+      }
+      historyIndex = (historyIndex + 1) & (numBlocks - 1);
+      if (blocksSeen < numBlocks)
+      {
+        return false;             // wait until the window is full
+      }
+    }
+    break;
+
+  case FilterExponential:
+    // state += (input - state)/numBlocks, where the input is scaled to the units of a full window
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+      const int32_t input = (int32_t)block[i] << (MaxBlocksShift + ExpFractionBits);
+      if (blocksSeen == 1)
+      {
+        state[i] = input;         // start from the first block instead of from zero, so that we don't have to wait for the filter to settle
+      }
+      else
+      {
+        state[i] += (input - state[i]) >> blocksShift;
+      }
+      out[i] = state[i] >> ExpFractionBits;
+    }
+    break;
+  }
+
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    result[i] = (out[i] > MaxResult) ? MaxResult : (out[i] < -MaxResult) ? -MaxResult : (int16_t)out[i];
+  }
+  return true;
+}
+
+uint8_t WindowFilter::getIndependentShift() const
+{
+  switch (mode)
+  {
+  case FilterBoxcar:
+  default:
+    return 0;                     // the windows don't overlap
+  case FilterSliding:
+    return blocksShift;           // one result per window, so that the windows don't overlap
+  case FilterExponential:
+    return blocksShift + 1;       // two time constants, which leaves a correlation of about e^-2
+  }
+}
+
+const char *WindowFilter::modeName(FilterMode m)
+{
+  switch (m)
+  {
+  case FilterBoxcar:      return "Boxcar";
+  case FilterSliding:     return "Sliding";
+  case FilterExponential: return "Exponential";
+  default:                return "?";
+  }
+}
+
+// End
@@ -0,0 +1,61 @@
+#ifndef __WindowFilter_Included
+#define __WindowFilter_Included
+
+#include <stdint.h>
+
+// Filter applied to the blocks of phase detector readings that the sampling ISR produces.
+// Each block holds the 4 bins accumulated over a fixed number of coil cycles. The filter combines the most recent blocks into a window,
+// and scales the result so that it is in the same units whatever the window length, so that thresholds don't need to change.
+enum FilterMode : uint8_t
+{
+  FilterBoxcar = 0,         // sum consecutive non-overlapping windows, giving one result per window (the original behaviour)
+  FilterSliding = 1,        // running sum over the most recent window, giving one result per block
+  FilterExponential = 2,    // single-pole IIR filter with the window length as its time constant, giving one result per block
+  NumFilterModes = 3
+};
+
+class WindowFilter
+{
+public:
+  static const uint8_t MaxBlocksShift = 4;
+  static const uint8_t MaxBlocks = 1u << MaxBlocksShift;      // the longest window we support, in blocks
+  static const int16_t MaxResult = 15000;                      // results are clamped to +/- this
+
+  WindowFilter() : mode(FilterBoxcar), blocksShift(MaxBlocksShift) { reset(); }
+
+  // Set the filter mode. This restarts the filter.
+  void setMode(FilterMode m);
+  FilterMode getMode() const { return mode; }
+
+  // Set the window length or time constant as a power of 2 number of blocks, from 0 to MaxBlocksShift. This restarts the filter.
+  void setBlocksShift(uint8_t shift);
+  uint8_t getBlocksShift() const { return blocksShift; }
+
+  // Return how many outputs apart two outputs must be for their noise to be nearly independent, as a power of 2.
+  // Consecutive outputs of the sliding and exponential filters share most of their blocks, so averaging them doesn't reduce the noise much.
+  uint8_t getIndependentShift() const;
+
+  // Discard all the blocks we have seen
+  void reset();
+
+  // Feed a block of 4 bins into the filter.
+  // Returns true and stores the new output in 'result' if the filter has an output ready, else returns false and leaves 'result' alone.
+  bool addBlock(const int16_t block[4], int16_t result[4]);
+
+  // Return the name of a filter mode, for display
+  static const char *modeName(FilterMode m);
+
+private:
+  FilterMode mode;
+  uint8_t blocksShift;
+  uint8_t blocksSeen;                   // number of blocks added since the filter was reset, saturating at the window length
+  uint8_t historyIndex;                 // where the next block goes in 'history' (sliding mode)
+  int32_t state[4];                     // running sums (boxcar and sliding), or filter state scaled by 2^ExpFractionBits (exponential)
+  int16_t history[MaxBlocks][4];        // the blocks in the current window (sliding mode)
+
+  static const uint8_t ExpFractionBits = 8;
+};
+
+#endif
+
+// End
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+# Decode the binary telemetry stream that MetalDetector sends when TELEMETRY is set to 1, and write it as CSV.
+#
+# Usage: decodetelemetry.py input [output.csv] [baud]
+#
+# The input is either a serial port (e.g. /dev/ttyUSB0), which needs pyserial, or a file holding a raw capture of the stream.
+# The output defaults to stdout. The baud rate defaults to 250000, to match TelemetryBaudRate in MetalDetector.ino.
+#
+# Frame format (see TelemetryFrame in MetalDetector.ino), all fields little-endian:
+#   sync bytes 0xA5 0x5A, length, sequence, ticks, misses, blocksDropped, coilTop, averages[4], offsets[4],
+#   amp1, amp2, ampAverage, phase1, phase2, phaseAverage, CRC-16/XMODEM of everything between the sync bytes and the CRC.
+# Frames that fail the length or CRC check are skipped, and we search for the next sync bytes.
+# Each tick is (coilTop + 1) CPU clocks, so the time column follows any change to the coil frequency.
+
+import csv
+import os
+import stat
+import struct
+import sys
+
+SYNC = b'\xA5\x5A'
+FRAME = struct.Struct('<2sBBHHHB4h4hHHHhhhH')
+F_CPU = 16000000.0
+
+COLUMNS = ['time', 'sequence', 'lost', 'misses', 'blocksDropped', 'coilTop',
+           'average0', 'average1', 'average2', 'average3',
+           'offset0', 'offset1', 'offset2', 'offset3',
+           'amp1', 'amp2', 'ampAverage', 'phase1', 'phase2', 'phaseAverage']
+
+def crc16xmodem(data):
+    crc = 0
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+class Decoder:
+    def __init__(self):
+        self.buffer = bytearray()
+        self.lastSequence = None
+        self.lastTicks = None
+        self.time = 0.0             # seconds since the first frame. Assumes there are fewer than 65536 ticks (about 1 second) between frames.
+        self.badFrames = 0
+
+    # Add some received bytes and return a list of the rows decoded from any complete frames
+    def add(self, data):
+        self.buffer += data
+        rows = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                del self.buffer[:-1]            # keep the last byte in case it is the first sync byte
+                return rows
+            del self.buffer[:start]
+            if len(self.buffer) < FRAME.size:
+                return rows
+            frame = bytes(self.buffer[:FRAME.size])
+            fields = FRAME.unpack(frame)
+            if fields[1] != FRAME.size or fields[-1] != crc16xmodem(frame[2:-2]):
+                self.badFrames += 1
+                del self.buffer[:1]             # not a valid frame, so look for the next sync bytes
+                continue
+            del self.buffer[:FRAME.size]
+            rows.append(self.makeRow(fields))
+
+    def makeRow(self, fields):
+        (_, _, sequence, ticks, misses, blocksDropped, coilTop) = fields[:7]
+        averages = fields[7:11]
+        offsets = fields[11:15]
+        (amp1, amp2, ampAverage, phase1, phase2, phaseAverage) = fields[15:21]
+        lost = 0 if self.lastSequence is None else (sequence - self.lastSequence - 1) & 0xFF
+        self.lastSequence = sequence
+        if self.lastTicks is not None:
+            # If the coil frequency changed between the frames, most of the ticks were at the new frequency
+            self.time += ((ticks - self.lastTicks) & 0xFFFF) * (coilTop + 1)/F_CPU
+        self.lastTicks = ticks
+        return ([round(self.time, 6), sequence, lost, misses, blocksDropped, coilTop] + list(averages) + list(offsets) +
+                [amp1, amp2, ampAverage, phase1/10.0, phase2/10.0, phaseAverage/10.0])
+
+def openInput(name, baud):
+    if stat.S_ISCHR(os.stat(name).st_mode):
+        import serial
+        port = serial.Serial(name, baud, timeout=0.1)
+        return lambda: port.read(4096)
+    f = open(name, 'rb')
+    return lambda: f.read(4096) or None
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("Usage: decodetelemetry.py input [output.csv] [baud]")
+    read = openInput(sys.argv[1], int(sys.argv[3]) if len(sys.argv) > 3 else 250000)
+    out = open(sys.argv[2], 'w', newline='') if len(sys.argv) > 2 else sys.stdout
+    writer = csv.writer(out)
+    writer.writerow(COLUMNS)
+    decoder = Decoder()
+    try:
+        while True:
+            data = read()
+            if data is None:
+                break
+            writer.writerows(decoder.add(data))
+            out.flush()
+    except KeyboardInterrupt:
+        pass
+    if decoder.badFrames != 0:
+        sys.stderr.write("%d bad frames skipped\n" % decoder.badFrames)
+
+if __name__ == '__main__':
+    main()
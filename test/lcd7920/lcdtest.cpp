@@ -0,0 +1,746 @@
+// Tests for the Lcd7920 driver, using the mock SPI interface in test/mock.
+// An emulation of the ST7920 decodes the bytes that the driver sends, so that the tests can check that the display ends up showing the
+// driver's image and text, and that the driver waits long enough after each command. Build with LCD7920_SHADOW set to test the shadow modes.
+// The glyph blitter is checked against the per-pixel text renderer of the original driver, and both are timed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "lcd7920.h"
+
+extern const PROGMEM LcdFont font10x10;
+extern const PROGMEM LcdFont font10x10Packed;
+extern const PROGMEM LcdFont font16x16;
+extern const PROGMEM LcdFont font16x16Packed;
+
+static unsigned int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+  if (!ok)
+  {
+    printf("FAILED: %s\n", what);
+    ++failures;
+  }
+}
+
+// Emulation of the ST7920 in serial mode. Each instruction is sent as 3 bytes: a sync byte (0xF8 for a command, 0xFA for data), then the
+// high nibble and the low nibble of the instruction, each in the top 4 bits of a byte.
+class St7920
+{
+public:
+  St7920() { reset(); }
+
+  void reset()
+  {
+    memset(gdram, 0, sizeof(gdram));
+    memset(ddram, ' ', sizeof(ddram));
+    extended = false;
+    gdramAddressStep = 0;
+    vertical = horizontal = 0;
+    ddramAddress = 0;
+    dataHigh = true;
+    bytePos = 0;
+    logPos = 0;
+    busyUntil = 0;
+    lastByteTime = 0;
+    timingErrors = 0;
+  }
+
+  // Decode the bytes that the driver has sent since the last call
+  void update()
+  {
+    while (logPos < mockSpiLog.size())
+    {
+      receive(mockSpiLog[logPos++]);
+    }
+  }
+
+  bool pixel(uint8_t x, uint8_t y) const
+  {
+    const uint16_t word = (y < 32) ? gdram[y][x/16] : gdram[y - 32][8 + x/16];
+    return (word & (0x8000u >> (x % 16))) != 0;
+  }
+
+  char text(uint8_t line, uint8_t pos) const { return ddram[line][pos]; }
+
+  unsigned int timingErrors;            // number of bytes sent too soon after the previous byte or command
+
+private:
+  uint16_t gdram[32][16];               // the 128x64 display is organised as 256x32, with the bottom half to the right of the top half
+  char ddram[4][16];
+  bool extended;                        // using the extended instruction set
+  uint8_t gdramAddressStep;             // 1 after the vertical address, when the next address command is the horizontal address
+  uint8_t vertical, horizontal;
+  uint8_t ddramAddress;
+  bool dataHigh;                        // the next data byte is the first of a 16-bit word
+  uint8_t bytePos;                      // which byte of the instruction we are expecting
+  uint8_t sync;
+  uint8_t instruction;
+  size_t logPos;
+  uint32_t busyUntil;                   // time when the last instruction finished executing
+  uint32_t lastByteTime;
+
+  void receive(const MockSpiByte& b)
+  {
+    if (lastByteTime != 0 && b.time < lastByteTime + mockSpiByteMicros)
+    {
+      ++timingErrors;                   // write collision, the previous byte hadn't finished
+    }
+    lastByteTime = b.time;
+    switch (bytePos)
+    {
+    case 0:
+      if ((b.data & 0xF9) != 0xF8)
+      {
+        return;                         // not a sync byte, so wait for one
+      }
+      if (b.time < busyUntil)
+      {
+        ++timingErrors;                 // the display hadn't finished the last instruction
+      }
+      sync = b.data;
+      bytePos = 1;
+      break;
+
+    case 1:
+      instruction = b.data & 0xF0;
+      bytePos = 2;
+      break;
+
+    case 2:
+      instruction |= b.data >> 4;
+      bytePos = 0;
+      execute(b.time + mockSpiByteMicros);
+      break;
+    }
+  }
+
+  void execute(uint32_t received)
+  {
+    const uint8_t c = instruction;
+    busyUntil = received + 72;
+    if (sync & 0x02)
+    {
+      // Data. The driver waits between words, not between the 2 bytes of a word.
+      busyUntil = received;
+      if (extended)
+      {
+        uint16_t& w = gdram[vertical & 31][horizontal & 15];
+        w = (dataHigh) ? (uint16_t)((w & 0x00FF) | (c << 8)) : (uint16_t)((w & 0xFF00) | c);
+        if (!dataHigh)
+        {
+          horizontal = (horizontal + 1) & 15;
+        }
+      }
+      else
+      {
+        const uint8_t line = ((ddramAddress >> 4) & 1) | ((ddramAddress >> 2) & 2);
+        ddram[line][2 * (ddramAddress & 7) + ((dataHigh) ? 0 : 1)] = c;
+        if (!dataHigh)
+        {
+          ddramAddress = (ddramAddress + 1) & 0x1F;
+        }
+      }
+      dataHigh = !dataHigh;
+      return;
+    }
+
+    dataHigh = true;
+    if ((c & 0xE0) == 0x20)
+    {
+      extended = (c & 0x04) != 0;       // function set
+      gdramAddressStep = 0;
+    }
+    else if (c & 0x80)
+    {
+      if (extended)
+      {
+        if (gdramAddressStep == 0)
+        {
+          vertical = c & 0x7F;
+          gdramAddressStep = 1;
+          busyUntil = received;         // the horizontal address can follow straight away
+        }
+        else
+        {
+          horizontal = c & 0x0F;
+          gdramAddressStep = 0;
+        }
+      }
+      else
+      {
+        ddramAddress = c & 0x1F;
+      }
+    }
+    else if (c == 0x01 && !extended)
+    {
+      memset(ddram, ' ', sizeof(ddram));
+      ddramAddress = 0;
+      busyUntil = received + 1600;
+    }
+  }
+};
+
+static St7920 display;
+
+// Check that the display shows what is in the driver's image
+static bool displayMatches(const Lcd7920& lcd)
+{
+  display.update();
+  for (uint8_t y = 0; y < 64; ++y)
+  {
+    for (uint8_t x = 0; x < 128; ++x)
+    {
+      if (display.pixel(x, y) != lcd.readPixel(x, y))
+      {
+        printf("Pixel %u,%u differs\n", x, y);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Flush and return the number of bytes sent, checking that the driver's count agrees with what went over SPI
+static uint16_t flushAndCount(Lcd7920& lcd)
+{
+  const size_t before = mockSpiLog.size();
+  lcd.flush();
+  const size_t sent = mockSpiLog.size() - before;
+  check(sent == lcd.getBytesSent(), "getBytesSent() doesn't match the bytes sent");
+  return (uint16_t)sent;
+}
+
+// Bytes that the old driver sent to flush a rectangle: for each row, an address command and then every word in the rectangle
+static uint16_t rectangleBytes(uint8_t r0, uint8_t r1, uint8_t c0, uint8_t c1)
+{
+  const uint8_t words = (c1 + 15)/16 - c0/16;
+  return (r1 - r0) * (6 + 6 * words);
+}
+
+// The metal detector's display, as drawn by its loop()
+static void drawMetalDetectorScreen(Lcd7920& lcd, int sensitivity, int bars)
+{
+  lcd.setCursor(0, 0);
+  lcd.print("IB Metal Detector v0.0");
+  lcd.setCursor(11, 0);
+  lcd.print("Cal noise 0.4");
+  lcd.clearToMargin();
+  lcd.setCursor(22, 0);
+  lcd.print("Sens ");
+  lcd.print(sensitivity);
+  lcd.clearToMargin();
+  lcd.setCursor(33, 0);
+  lcd.print("12.5");
+  lcd.clearToMargin();
+  lcd.setCursor(33, 32);
+  lcd.print("12.7");
+  lcd.setCursor(33, 64);
+  lcd.print(-30);
+  lcd.setCursor(33, 96);
+  lcd.print(-29);
+  lcd.setCursor(44, 0);
+  lcd.print("Foil");
+  lcd.clearToMargin();
+  lcd.setCursor(55, 0);
+  for (int i = 0; i < bars; ++i)
+  {
+    lcd.write('*');
+  }
+  lcd.clearToMargin();
+}
+
+// Bytes sent per frame for the metal detector display
+static void testBytesPerFrame()
+{
+  mockSpiLog.clear();
+  display.reset();
+  Lcd7920 lcd(13, 11, 10, true);
+  lcd.begin();
+  lcd.setFont(&font10x10Packed);
+  check(displayMatches(lcd), "display doesn't match after begin()");
+
+  drawMetalDetectorScreen(lcd, 5, 3);
+  const uint16_t firstFrame = flushAndCount(lcd);
+  check(displayMatches(lcd), "display doesn't match after the first frame");
+
+  // Redraw the same screen, as the detector does for every result
+  const uint16_t sameFrame = flushAndCount(lcd);
+  check(sameFrame == 0, "a flush with nothing drawn sent something");
+  drawMetalDetectorScreen(lcd, 5, 3);
+  const uint16_t redrawFrame = flushAndCount(lcd);
+  check(displayMatches(lcd), "display doesn't match after redrawing the same screen");
+
+  // Change the sensitivity on row 2 and the bar graph on row 5, at opposite corners of the changed area
+  lcd.setCursor(22, 0);
+  lcd.print("Sens ");
+  lcd.print(6);
+  lcd.clearToMargin();
+  lcd.setCursor(55, 0);
+  lcd.print("****");
+  lcd.clearToMargin();
+  const uint16_t updateFrame = flushAndCount(lcd);
+  const uint16_t updateRectangle = rectangleBytes(22, 64, 0, 128);
+  check(displayMatches(lcd), "display doesn't match after the update");
+  check(updateFrame < updateRectangle, "sent more than a dirty rectangle flush would have");
+
+  printf("Bytes per frame: first %u, same screen redrawn %u, sensitivity and bar graph update %u (a dirty rectangle would be %u)\n",
+         firstFrame, redrawFrame, updateFrame, updateRectangle);
+  check(display.timingErrors == 0, "bytes sent too soon after a command");
+}
+
+#if LCD7920_ALPHA
+
+// Alphanumeric mode, with graphics drawn on top of the text
+static void testAlphanumeric()
+{
+  mockSpiLog.clear();
+  display.reset();
+  Lcd7920 lcd(13, 11, 10, true);
+  lcd.begin(false);
+  lcd.setCursor(0, 0);
+  lcd.print("Sens 5");
+  lcd.setCursor(48, 16);
+  lcd.print("Foil");
+  lcd.line(0, 20, 127, 20, PixelSet);
+  const uint16_t first = flushAndCount(lcd);
+  lcd.setCursor(0, 40);
+  lcd.print("6");
+  const uint16_t update = flushAndCount(lcd);
+  display.update();
+
+  const char *expected[4] = { "Sens 6          ", "                ", "                ", "  Foil          " };
+  bool textOk = true;
+  for (uint8_t line = 0; line < 4; ++line)
+  {
+    for (uint8_t pos = 0; pos < 16; ++pos)
+    {
+      textOk = textOk && display.text(line, pos) == expected[line][pos];
+    }
+  }
+  check(textOk, "alphanumeric text doesn't match");
+  check(displayMatches(lcd), "graphics don't match in alphanumeric mode");
+  check(display.timingErrors == 0, "bytes sent too soon after a command in alphanumeric mode");
+  printf("Alphanumeric mode: first frame %u bytes, one character changed %u bytes\n", first, update);
+}
+
+#endif
+
+// Draw some random text and graphics, the same each time for the same seed
+static void drawRandom(Lcd7920& lcd, unsigned int seed, bool graphicsMode)
+{
+  static const LcdFont * const fonts[] = { &font10x10, &font10x10Packed, &font16x16, &font16x16Packed };
+  srand(seed);
+  const int ops = 1 + rand() % 12;
+  for (int i = 0; i < ops; ++i)
+  {
+    switch (rand() % 6)
+    {
+    case 0:
+    case 1:
+      lcd.setFont(fonts[rand() % 4]);
+      lcd.setCursor(rand() % 64, rand() % 128);
+      lcd.textInvert(graphicsMode && rand() % 4 == 0);
+      for (int n = rand() % 10; n != 0; --n)
+      {
+        lcd.write(' ' + rand() % 95);
+      }
+      if (rand() % 2 == 0)
+      {
+        lcd.clearToMargin();
+      }
+      break;
+
+    case 2:
+      lcd.line(rand() % 128, rand() % 64, rand() % 128, rand() % 64, (PixelMode)(rand() % 3));
+      break;
+
+    case 3:
+      lcd.setPixel(rand() % 128, rand() % 64, (PixelMode)(rand() % 3));
+      break;
+
+    case 4:
+      lcd.circle(rand() % 128, rand() % 64, rand() % 20, PixelFlip);
+      break;
+
+    case 5:
+      if (rand() % 8 == 0)
+      {
+        lcd.clear();
+      }
+      break;
+    }
+  }
+}
+
+// Time source with a 16us resolution, like the metal detector's tick counter. Polling it takes 1us.
+static uint16_t coarseTimeSource()
+{
+  return (uint16_t)(mockMicros++ & ~15u);
+}
+
+// Check that beginFlush() and flushStep() send exactly the same bytes as flush(), however the calls to flushStep() are spread out in time.
+// Then check that drawing while a flush is in progress leaves the display right after the next flush.
+static void testAsyncFlush(bool graphicsMode, bool coarseTime)
+{
+  const int frames = 200;
+  std::vector<uint8_t> syncBytes;
+  Lcd7920 syncLcd(13, 11, 10, true);
+  mockSpiLog.clear();
+  syncLcd.begin(graphicsMode);
+  if (coarseTime)
+  {
+    syncLcd.setTimeSource(coarseTimeSource, 16);
+  }
+  for (int frame = 0; frame < frames; ++frame)
+  {
+    drawRandom(syncLcd, frame, graphicsMode);
+    const size_t start = mockSpiLog.size();
+    syncLcd.flush();
+    for (size_t i = start; i < mockSpiLog.size(); ++i)
+    {
+      syncBytes.push_back(mockSpiLog[i].data);
+    }
+  }
+
+  std::vector<uint8_t> asyncBytes;
+  Lcd7920 lcd(13, 11, 10, true);
+  mockSpiLog.clear();
+  display.reset();
+  lcd.begin(graphicsMode);
+  if (coarseTime)
+  {
+    lcd.setTimeSource(coarseTimeSource, 16);
+  }
+  srand(1000);
+  unsigned long steps = 0;
+  for (int frame = 0; frame < frames; ++frame)
+  {
+    drawRandom(lcd, frame, graphicsMode);
+    const size_t start = mockSpiLog.size();
+    lcd.beginFlush();
+    const unsigned int seed = rand();
+    srand(seed);
+    while (lcd.flushStep())
+    {
+      mockMicros += rand() % 40;        // the caller does other work between steps
+      ++steps;
+    }
+    check(!lcd.isFlushing(), "isFlushing() is true after flushStep() returned false");
+    for (size_t i = start; i < mockSpiLog.size(); ++i)
+    {
+      asyncBytes.push_back(mockSpiLog[i].data);
+    }
+  }
+  check(asyncBytes == syncBytes, "the asynchronous flush sent different bytes from the synchronous one");
+  check(displayMatches(lcd), "display doesn't match after asynchronous flushes");
+  display.update();
+  check(display.timingErrors == 0, "bytes sent too soon after a command by the asynchronous flush");
+
+  // Draw while the flush is in progress
+  for (int frame = 0; frame < frames; ++frame)
+  {
+    drawRandom(lcd, frames + frame, graphicsMode);
+    lcd.beginFlush();
+    for (int i = rand() % 200; i != 0 && lcd.flushStep(); --i)
+    {
+      mockMicros += rand() % 40;
+    }
+    drawRandom(lcd, 2 * frames + frame, graphicsMode);
+    while (lcd.flushStep())
+    {
+      mockMicros += rand() % 40;
+    }
+  }
+  lcd.flush();
+  check(displayMatches(lcd), "display doesn't match after drawing during flushes");
+  display.update();
+  check(display.timingErrors == 0, "bytes sent too soon after a command when drawing during flushes");
+  printf("Asynchronous flush (%s mode, %s time source): %u bytes in %lu steps, same as the synchronous flush\n",
+         (graphicsMode) ? "graphics" : "alphanumeric", (coarseTime) ? "16us" : "1us", (unsigned int)syncBytes.size(), steps);
+}
+
+// Change a word after the flush has looked at its row but before it has sent the word, then change it back before the next flush.
+// The display must end up showing the word as it was changed back, even though that is what the image held when the first flush began.
+static void testChangeRevertDuringFlush()
+{
+  Lcd7920 lcd(13, 11, 10, true);
+  mockSpiLog.clear();
+  display.reset();
+  lcd.begin(true);
+  lcd.clear();
+  lcd.flush();
+
+  // Word 0 and word 7 of row 10 are dirty. They are far enough apart for the flush to set the address before each of them.
+  const uint8_t r = 10;
+  lcd.setPixel(0, r, PixelSet);
+  lcd.setPixel(120, r, PixelSet);
+  lcd.beginFlush();
+  while (lcd.getBytesSent() < 12 && lcd.flushStep())
+  {
+    mockMicros += 10;                   // step until the address and word 0 have been sent
+  }
+  check(lcd.isFlushing(), "flush finished before word 7 was sent");
+  lcd.setPixel(121, r, PixelSet);       // changed after the row was looked at, so word 7 goes with both pixels set
+  while (lcd.flushStep())
+  {
+    mockMicros += 10;
+  }
+  check(displayMatches(lcd), "display doesn't match after changing a word during a flush");
+
+  lcd.setPixel(121, r, PixelClear);     // back to what the image held when the first flush began
+  lcd.flush();
+  check(displayMatches(lcd), "display doesn't match after changing a word during a flush and changing it back");
+  display.update();
+  check(display.timingErrors == 0, "bytes sent too soon after a command when changing a word during a flush");
+  printf("Word changed during a flush and changed back: display %s\n", displayMatches(lcd) ? "matches" : "doesn't match");
+}
+
+// Text renderer from the original driver, which sets or clears one pixel at a time, for checking the glyph blitter against.
+// It only handles column-major fonts. The packed fonts are converted from the column-major ones, so they must draw the same pixels.
+class ReferenceText
+{
+public:
+  ReferenceText() : font(nullptr) { clear(); }
+
+  void clear()
+  {
+    memset(image, 0, sizeof(image));
+    setCursor(0, 0);
+    textInverted = false;
+    rightMargin = 128;
+  }
+
+  void setFont(const LcdFont *f) { font = f; }
+  void setRightMargin(uint8_t r) { rightMargin = (r > 128) ? 128 : r; }
+
+  void setCursor(uint8_t r, uint8_t c)
+  {
+    row = r;
+    column = c;
+    lastCharColData = 0;
+    justSetCursor = true;
+  }
+
+  void textInvert(bool b)
+  {
+    if (b != textInverted)
+    {
+      textInverted = b;
+      if (!justSetCursor)
+      {
+        lastCharColData = 0xFFFF;
+      }
+    }
+  }
+
+  void write(uint8_t ch)
+  {
+    if (column < rightMargin)
+    {
+      if (ch < font->startCharacter || ch > font->endCharacter)
+      {
+        return;
+      }
+      const uint8_t bytesPerColumn = (font->height + 7)/8;
+      const uint8_t *fontPtr = font->ptr + (bytesPerColumn * font->width + 1) * (ch - font->startCharacter);
+      const uint16_t cmask = (1u << font->height) - 1u;
+      uint8_t nCols = *fontPtr++;
+      uint16_t thisCharColData = mockReadWord(fontPtr) & cmask;
+      if (thisCharColData == 0)
+      {
+        thisCharColData = mockReadWord(fontPtr + 2) & cmask;
+      }
+      if (((thisCharColData | (thisCharColData << 1)) & (lastCharColData | (lastCharColData << 1))) != 0)
+      {
+        drawColumn(0);
+      }
+      while (nCols != 0 && column < rightMargin)
+      {
+        const uint16_t colData = mockReadWord(fontPtr);
+        fontPtr += bytesPerColumn;
+        if (colData != 0)
+        {
+          lastCharColData = colData & cmask;
+        }
+        drawColumn(colData);
+        --nCols;
+      }
+    }
+    justSetCursor = false;
+  }
+
+  void clearToMargin()
+  {
+    while (column < rightMargin)
+    {
+      drawColumn(0);
+    }
+  }
+
+  bool pixel(uint8_t x, uint8_t y) const { return (image[y * 16 + x/8] & (0x80u >> (x % 8))) != 0; }
+
+private:
+  uint8_t image[1024];
+  const LcdFont *font;
+  uint8_t row, column, rightMargin;
+  bool textInverted, justSetCursor;
+  uint16_t lastCharColData;
+
+  void drawColumn(uint16_t colData)
+  {
+    const uint8_t mask = 0x80 >> (column & 7);
+    uint8_t *p = image + (row * 16) + (column/8);
+    for (uint8_t i = 0; i < font->height && p < image + sizeof(image); ++i)
+    {
+      if (((colData & 1u) != 0) != textInverted)
+      {
+        *p |= mask;
+      }
+      else
+      {
+        *p &= (uint8_t)~mask;
+      }
+      colData >>= 1;
+      p += 16;
+    }
+    ++column;
+  }
+};
+
+// Check that the glyph blitter draws the same pixels as the original per-pixel code, for both fonts in both formats, including clipping at
+// the right margin and the bottom of the display, inverted text and kerning.
+static void testGlyphs()
+{
+  static const LcdFont * const columnFonts[] = { &font10x10, &font16x16 };
+  static const LcdFont * const packedFonts[] = { &font10x10Packed, &font16x16Packed };
+  Lcd7920 lcd(13, 11, 10, true);
+  lcd.begin();
+  ReferenceText ref;
+  lcd.setFont(&font10x10);
+  ref.setFont(&font10x10);
+  srand(42);
+  unsigned int mismatches = 0;
+  for (int batch = 0; batch < 2000 && mismatches == 0; ++batch)
+  {
+    if (rand() % 20 == 0)
+    {
+      lcd.clear();
+      ref.clear();
+    }
+    for (int op = 0; op < 20; ++op)
+    {
+      switch (rand() % 8)
+      {
+      case 0:
+        {
+          const int f = rand() % 2;
+          lcd.setFont((rand() % 2) ? packedFonts[f] : columnFonts[f]);
+          ref.setFont(columnFonts[f]);
+        }
+        // fall through
+      case 1:
+        {
+          const uint8_t r = rand() % 64, c = rand() % 128;
+          lcd.setCursor(r, c);
+          ref.setCursor(r, c);
+        }
+        break;
+
+      case 2:
+        {
+          const uint8_t m = 40 + rand() % 100;
+          lcd.setRightMargin(m);
+          ref.setRightMargin(m);
+        }
+        break;
+
+      case 3:
+        {
+          const bool inv = (rand() % 3 == 0);
+          lcd.textInvert(inv);
+          ref.textInvert(inv);
+        }
+        break;
+
+      case 4:
+        lcd.clearToMargin();
+        ref.clearToMargin();
+        break;
+
+      default:
+        for (int n = 1 + rand() % 6; n != 0; --n)
+        {
+          const uint8_t ch = (rand() % 30 == 0) ? 0x7F + rand() % 16 : ' ' + rand() % 95;
+          lcd.write(ch);
+          ref.write(ch);
+        }
+        break;
+      }
+    }
+    for (uint8_t y = 0; y < 64; ++y)
+    {
+      for (uint8_t x = 0; x < 128; ++x)
+      {
+        if (lcd.readPixel(x, y) != ref.pixel(x, y))
+        {
+          ++mismatches;
+        }
+      }
+    }
+  }
+  check(mismatches == 0, "the glyph blitter draws different pixels from the per-pixel renderer");
+}
+
+// Rendering speed on the host, in glyphs per second, for the blitter and the per-pixel renderer
+template<class T> static double glyphsPerSecond(T& target, const LcdFont *font)
+{
+  static const char text[] = "Sens 12 Coil 244 7.84kHz Foil 12.5 -30";
+  const int lines = 20000;
+  target.setFont(font);
+  unsigned long glyphs = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < lines; ++i)
+  {
+    target.setCursor((i * 11) % 50, 0);
+    for (const char *p = text; *p != 0; ++p)
+    {
+      target.write(*p);
+      ++glyphs;
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return glyphs/std::chrono::duration<double>(end - start).count();
+}
+
+static void benchmarkGlyphs()
+{
+  Lcd7920 lcd(13, 11, 10, true);
+  lcd.begin();
+  static ReferenceText ref;
+  printf("Glyphs/s on this host: 10x10 per-pixel %.0f, blitter %.0f, packed %.0f; 16x16 per-pixel %.0f, blitter %.0f, packed %.0f\n",
+         glyphsPerSecond(ref, &font10x10), glyphsPerSecond(lcd, &font10x10), glyphsPerSecond(lcd, &font10x10Packed),
+         glyphsPerSecond(ref, &font16x16), glyphsPerSecond(lcd, &font16x16), glyphsPerSecond(lcd, &font16x16Packed));
+}
+
+int main()
+{
+  printf("LCD7920_SHADOW = %d, LCD7920_ALPHA = %d, sizeof(Lcd7920) = %u\n", LCD7920_SHADOW, LCD7920_ALPHA, (unsigned int)sizeof(Lcd7920));
+  testBytesPerFrame();
+#if LCD7920_ALPHA
+  testAlphanumeric();
+#endif
+  testAsyncFlush(true, false);
+  testAsyncFlush(true, true);
+#if LCD7920_ALPHA
+  testAsyncFlush(false, false);
+#endif
+  testChangeRevertDuringFlush();
+  testGlyphs();
+  benchmarkGlyphs();
+  printf("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+  return (failures == 0) ? 0 : 1;
+}
+
+// End
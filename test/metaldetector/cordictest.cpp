@@ -0,0 +1,139 @@
+// Test of the integer CORDIC against the C library.
+// Checks the accuracy that Cordic.h promises over a grid covering the whole input range, at the edges of the range, and for random vectors,
+// and compares the time a call takes on the host with sqrt plus atan2. The host timings only compare the algorithms; on the target the
+// CORDIC wins by more, because the AVR has no FPU.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include "Cordic.h"
+
+static double worstMagnitudeError = 0.0;
+static double worstPhaseError = 0.0;
+static unsigned long failures = 0;
+static unsigned long vectors = 0;
+
+static void check(int16_t x, int16_t y)
+{
+  uint16_t magnitude;
+  int16_t phase;
+  cordicToPolar(x, y, magnitude, phase);
+  ++vectors;
+
+  const double expectedMagnitude = hypot((double)x, (double)y);
+  const double magnitudeError = fabs(magnitude - expectedMagnitude);
+  double phaseError = 0.0;
+  if (x != 0 || y != 0)
+  {
+    phaseError = fabs(phase - atan2((double)y, (double)x) * 1800.0/M_PI);
+    if (phaseError > 1800.0)
+    {
+      phaseError = 3600.0 - phaseError;         // +180 and -180 degrees are the same angle
+    }
+  }
+  if (magnitudeError > worstMagnitudeError)
+  {
+    worstMagnitudeError = magnitudeError;
+  }
+  if (phaseError > worstPhaseError)
+  {
+    worstPhaseError = phaseError;
+  }
+  if (magnitudeError > 1.0 || phaseError > 1.0 || phase < -1800 || phase > 1800)
+  {
+    if (failures < 10)
+    {
+      printf("FAILED: x %d y %d gave magnitude %u phase %d, expected %.2f %.2f\n", x, y, magnitude, phase, expectedMagnitude,
+             atan2((double)y, (double)x) * 1800.0/M_PI);
+    }
+    ++failures;
+  }
+}
+
+// Time a conversion function over a set of vectors, returning nanoseconds per call
+template<class F> static double timeCalls(const int16_t *xs, const int16_t *ys, unsigned int n, unsigned int repeats, F f)
+{
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned int r = 0; r < repeats; ++r)
+  {
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      f(xs[i], ys[i]);
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count()/((double)n * repeats);
+}
+
+int main()
+{
+  // Every vector on a grid over the range of the filter outputs, which the detector passes after calibration
+  for (int x = -15000; x <= 15000; x += 7)
+  {
+    for (int y = -15000; y <= 15000; y += 7)
+    {
+      check(x, y);
+    }
+  }
+
+  // Small vectors, where the rounding matters most
+  for (int x = -64; x <= 64; ++x)
+  {
+    for (int y = -64; y <= 64; ++y)
+    {
+      check(x, y);
+    }
+  }
+
+  // The axes, the diagonals and the corners of the whole input range
+  for (int v = -32767; v <= 32767; ++v)
+  {
+    check(v, 0);
+    check(0, v);
+    check(v, v);
+    check(v, -v);
+    check(32767, v);
+    check(-32767, v);
+    check(v, 32767);
+    check(v, -32767);
+  }
+
+  // Random vectors over the whole input range
+  srand(1);
+  for (int i = 0; i < 5000000; ++i)
+  {
+    check((int16_t)(rand() % 65535 - 32767), (int16_t)(rand() % 65535 - 32767));
+  }
+
+  printf("%lu vectors, worst magnitude error %.3f counts, worst phase error %.3f tenths of a degree\n", vectors, worstMagnitudeError,
+         worstPhaseError);
+
+  // Timings
+  const unsigned int n = 4096;
+  static int16_t xs[n], ys[n];
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    xs[i] = (int16_t)(rand() % 30001 - 15000);
+    ys[i] = (int16_t)(rand() % 30001 - 15000);
+  }
+  volatile uint32_t sink = 0;
+  const double cordicNanos = timeCalls(xs, ys, n, 500, [&](int16_t x, int16_t y)
+    {
+      uint16_t m;
+      int16_t p;
+      cordicToPolar(x, y, m, p);
+      sink = sink + m + p;
+    });
+  const double floatNanos = timeCalls(xs, ys, n, 500, [&](int16_t x, int16_t y)
+    {
+      const float fx = x, fy = y;
+      sink = sink + (uint32_t)sqrtf(fx * fx + fy * fy) + (uint32_t)(int32_t)(atan2f(fy, fx) * (1800.0f/(float)M_PI));
+    });
+  printf("Host time per call: CORDIC %.1fns, float sqrt + atan2 %.1fns\n", cordicNanos, floatNanos);
+
+  printf("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+  return (failures == 0) ? 0 : 1;
+}
+
+// End
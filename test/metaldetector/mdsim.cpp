@@ -0,0 +1,501 @@
+// Host simulation of the metal detector sketch.
+// The sketch is compiled against the mock AVR registers in test/mock. The driver calls the timer 1 ISR once per simulated tick, with the ADC
+// reading taken from a synthetic receive coil waveform, and calls loop() whenever the ISR has a block ready. On the host the ISR can't interrupt
+// loop(), so the driver charges the time that each part of loop() would take on the target using the cost model below, and runs the ISR for
+// that many ticks before carrying on. While no block is ready, the driver runs the body of loop()'s wait loop itself.
+//
+// The waveform is the signal from a target at the receive coil: a sine wave at the coil frequency with a chosen amplitude and phase, plus noise.
+// For each scenario the simulation checks that the amplitudes, phases and target class the sketch calculates match the waveform, and at the
+// end it reports the cost of an ISR call on the host, the simulated throughput in samples/s, and the blocks the ISR dropped.
+// It also retunes the coil and checks the results at the new frequency, and checks that the settings survive a save and load through EEPROM.
+// It measures how well a calibration finds the offsets and the noise in each filter mode, from consecutive outputs and from independent ones.
+// Finally it checks the duty cycle of the tone at every pitch and volume.
+//
+// Usage: mdsim [-s seconds] [-n noise] [-l loopClocks] [-r resultClocks] [-d displayClocks] [-b byteClocks]
+// The sketch's ADC_MODE is chosen when building, see test/Makefile.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+
+// setCoilTop() waits for the ISR to load the new TOP value, which it can't do on the host while loop() waits, so the wait runs the ISR instead
+static void simWaitForCoilTop();
+#define WAIT_FOR_COIL_TOP()  simWaitForCoilTop()
+
+#include "../../MetalDetector/MetalDetector.ino"
+
+// Cost model, in CPU clocks on the target. These are estimates for a 16MHz ATmega328p; pass different values on the command line to see
+// how much slack loop() has.
+struct CostModel
+{
+  uint16_t isrClocks = 120;             // average clocks the timer 1 ISR takes, including entry and exit, which loop() doesn't get
+  uint32_t loopClocks = 400;            // one call of loop() that just passes a block to the filter
+  uint32_t resultClocks = 8000;         // processing a filter output: two CORDIC conversions, the classifier and the audio
+  uint32_t displayClocks = 40000;       // rendering the results into the LCD image
+  uint32_t byteClocks = 150;            // bit-banging one byte to the LCD
+  uint32_t pollClocks = 40;             // one pass of the wait loop in loop()
+};
+
+static CostModel cost;
+static uint32_t pendingClocks = 0;      // clocks charged to loop() that haven't yet added up to a whole tick
+
+// The waveform
+static double targetAmplitude = 0.0;    // peak amplitude at the ADC, in 10-bit ADC counts
+static double targetPhase = 0.0;        // degrees
+static double noiseAmplitude = 2.0;     // RMS noise, in 10-bit ADC counts
+static const double adcMidpoint = 512.0;
+static uint32_t sampleNumber = 0;       // number of ISR calls so far
+static uint32_t randomState = 12345;
+
+// Gaussian noise from the sum of uniform random numbers, so that runs are repeatable
+static double noise()
+{
+  double sum = 0.0;
+  for (int i = 0; i < 4; ++i)
+  {
+    randomState = randomState * 1664525u + 1013904223u;
+    sum += (double)(randomState >> 8)/(double)(1u << 24) - 0.5;
+  }
+  return sum * sqrt(3.0) * noiseAmplitude;
+}
+
+// Simulate one timer 1 overflow: load the ADC result for this sample, set the timer 0 phase counter, and call the ISR
+static void runIsr()
+{
+  const uint8_t phaseCounter = sampleNumber & 7;
+  double v = adcMidpoint + targetAmplitude * sin(2.0 * M_PI * phaseCounter/8.0 + targetPhase * M_PI/180.0) + noise();
+  v = (v < 0.0) ? 0.0 : (v > 1023.0) ? 1023.0 : v;
+  const uint16_t reading = (uint16_t)lround(v);
+  ADC = reading;
+  ADCH = (uint8_t)(reading >> 2);      // the left-adjusted result that the 8-bit mode reads
+  TCNT0 = phaseCounter;
+  TIMER1_OVF_vect();
+  ++sampleNumber;
+}
+
+// Charge some clocks of loop() time, running the ISR for every tick that passes
+static void charge(uint32_t clocks)
+{
+  const uint16_t clocksPerTick = (coilTop + 1u) - cost.isrClocks;
+  pendingClocks += clocks;
+  while (pendingClocks >= clocksPerTick)
+  {
+    pendingClocks -= clocksPerTick;
+    runIsr();
+  }
+}
+
+static void simWaitForCoilTop()
+{
+  while (pendingCoilTop != 0)
+  {
+    charge(cost.pollClocks);
+  }
+}
+
+// Time source for the LCD driver, which charges for each poll so that the command delays pass
+static uint16_t simTimeSource()
+{
+  charge(cost.pollClocks);
+  return tickMicros();
+}
+
+static uint16_t lastBytesSent = 0;
+
+// Charge for the bytes the LCD driver has sent since we last looked
+static void chargeLcdBytes()
+{
+  const uint16_t sent = lcd->getBytesSent();
+  const uint16_t newBytes = (sent >= lastBytesSent) ? sent - lastBytesSent : sent;    // beginFlush() resets the count
+  lastBytesSent = sent;
+  charge(newBytes * cost.byteClocks);
+}
+
+// Run loop() once, after the ISR has a block ready
+static void runLoop()
+{
+  while (blocksWritten == blocksRead)
+  {
+    // The body of loop()'s wait loop
+    const uint16_t localTicks = readTicks();
+    if ((localTicks - lastPollTime) >= PollInterval)
+    {
+      lastPollTime = localTicks;
+      scanner.scan();
+    }
+    lcd->flushStep();
+    chargeLcdBytes();
+    charge(cost.pollClocks);
+  }
+
+  int16_t oldAverages[4];
+  memcpy(oldAverages, averages, sizeof(averages));
+  const bool wasFlushing = lcd->isFlushing();
+  loop();
+  chargeLcdBytes();
+  uint32_t clocks = cost.loopClocks;
+  if (memcmp(oldAverages, averages, sizeof(averages)) != 0)
+  {
+    clocks += cost.resultClocks;        // the filter produced an output (with noise, the averages always change)
+  }
+  if (!wasFlushing && lcd->isFlushing())
+  {
+    clocks += cost.displayClocks;       // loop() rendered the results and started a flush
+  }
+  charge(clocks);
+}
+
+// Run the simulation for a number of ticks
+static void runTicks(uint32_t numTicks)
+{
+  const uint32_t end = sampleNumber + numTicks;
+  while ((int32_t)(sampleNumber - end) < 0)
+  {
+    runLoop();
+  }
+}
+
+static double ticksPerSecond()
+{
+  return (double)F_CPU/(coilTop + 1u);
+}
+
+// Difference between two phases in tenths of a degree, wrapped into -1800 to +1799
+static int phaseError(int a, int b)
+{
+  int d = (a - b) % 3600;
+  if (d < -1800) d += 3600;
+  if (d >= 1800) d -= 3600;
+  return d;
+}
+
+struct Scenario
+{
+  const char *name;
+  double amplitude;                     // ADC counts
+  double phase;                         // phase average we want the sketch to report, in degrees
+  TargetClass expected;
+};
+
+// Each target's waveform phase is chosen so that the phase average comes out at the given value. The sketch reports the phase of the waveform
+// plus 45 degrees (the first phase detector is half way between the first two bins) minus phaseAdjust.
+static const Scenario scenarios[] =
+{
+  { "no target",    0.0,    0.0,  TargetNone },
+  { "iron",        20.0,    5.0,  TargetIron },
+  { "foil",        20.0,  -30.0,  TargetFoil },
+  { "gold",        20.0,  -55.0,  TargetGold },
+  { "coin",        20.0,  -90.0,  TargetCoin },
+  { "strong coin", 26.0, -120.0,  TargetCoin },
+  { "overload",    60.0,  -30.0,  TargetOverload },
+};
+
+static bool runScenario(const Scenario& s)
+{
+  targetAmplitude = s.amplitude;
+  targetPhase = s.phase - 45.0 + phaseAdjust/10.0;
+
+  // Run for several windows, so that the last result comes from a window that holds only this waveform
+  runTicks(80u * 8u * coilCyclesPerBlock);
+
+  // The results are in units of a whole window. Each block is scaled to hold 2 * amplitude * 64 coil cycles, in the 8-bit units.
+  const double expectedAmp = 2.0 * (s.amplitude/4.0) * 64.0 * (1u << WindowFilter::MaxBlocksShift);
+  const bool overloaded = expectedAmp >= WindowFilter::MaxResult;
+  bool ok = (targetClass == s.expected);
+  if (s.amplitude != 0.0 && !overloaded)
+  {
+    const int expectedPhase = (int)lround(s.phase * 10.0);
+    ok = ok && fabs(ampAverage - expectedAmp) <= expectedAmp * 0.02
+            && abs(phaseError(phase1 - phaseAdjust, expectedPhase)) <= 10
+            && abs(phaseError(phase2 - phaseAdjust, expectedPhase)) <= 10
+            && abs(phaseError(phaseAverage, expectedPhase)) <= 10;
+  }
+  printf("%-12s amp %5u (expected %5.0f) phases %5d %5d average %5d (expected %5d) class %-8s %s\n",
+         s.name, ampAverage, overloaded ? (double)WindowFilter::MaxResult : expectedAmp, phase1, phase2, phaseAverage,
+         (int)lround(s.phase * 10.0), Classifier::className(targetClass), ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// Change the coil frequency, check that the ISR loaded the new TOP value, and run the target scenarios again
+static bool testRetune(uint8_t top)
+{
+  lcd->beginFlush();                    // setCoilTop() must finish this before it changes the tick length
+  setCoilTop(top);
+  bool ok = (coilTop == top && ICR1L == top && OCR1AL == top/2 && pendingCoilTop == 0 && !lcd->isFlushing());
+  printf("Coil TOP %u (%.0f ticks/s), phaseAdjust %d %s\n", coilTop, ticksPerSecond(), phaseAdjust, ok ? "ok" : "FAILED");
+  for (const Scenario& s : scenarios)
+  {
+    ok = runScenario(s) && ok;
+  }
+  return ok;
+}
+
+// Save the settings, check that they load back, that saving them again doesn't write to the EEPROM, and that bad settings are ignored
+static bool testSettings()
+{
+  sensitivity = 17;
+  filter.setMode(FilterSliding);
+  filter.setBlocksShift(2);
+  classifier.setRejected(TargetFoil, true);
+  volume = 3;
+  audioMode = AudioId;
+  saveSettings();
+  const unsigned int writes = EEPROM.writes;
+  saveSettings();
+  bool ok = (EEPROM.writes == writes);
+
+  const uint8_t savedTop = coilTop;
+  coilTop = MinCoilTop;
+  sensitivity = 1;
+  filter.setMode(FilterBoxcar);
+  filter.setBlocksShift(WindowFilter::MaxBlocksShift);
+  classifier.setRejectMask(0);
+  volume = AudioEngine::MaxVolume;
+  audioMode = AudioVco;
+  loadSettings();
+  ok = ok && coilTop == savedTop && sensitivity == 17 && filter.getMode() == FilterSliding && filter.getBlocksShift() == 2
+          && classifier.getRejectMask() == (1u << TargetFoil) && volume == 3 && audioMode == AudioId;
+
+  // Corrupt one byte, which should leave the settings as they are
+  EEPROM.data[SettingsEepromAddress + offsetof(SavedSettings, sensitivity)] ^= 1;
+  sensitivity = 9;
+  loadSettings();
+  ok = ok && sensitivity == 9;
+
+  sensitivity = 5;
+  filter.setMode(FilterBoxcar);
+  filter.setBlocksShift(WindowFilter::MaxBlocksShift);
+  classifier.setRejectMask(0);
+  volume = AudioEngine::MaxVolume;
+  audioMode = AudioVco;
+  printf("Settings saved and loaded %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// Run until the filter has produced a number of outputs with no target present, and return the mean of each bin and the RMS noise
+// averaged over the bins, which is what a calibration should find
+static void measureOutputs(unsigned int numResults, double mean[4], double& noise)
+{
+  double sums[4] = { 0.0 }, sumSquares[4] = { 0.0 };
+  for (unsigned int n = 0; n < numResults; )
+  {
+    int16_t oldAverages[4];
+    memcpy(oldAverages, averages, sizeof(averages));
+    runLoop();
+    if (memcmp(oldAverages, averages, sizeof(averages)) != 0)
+    {
+      for (uint8_t i = 0; i < 4; ++i)
+      {
+        sums[i] += averages[i];
+        sumSquares[i] += (double)averages[i] * averages[i];
+      }
+      ++n;
+    }
+  }
+  noise = 0.0;
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    mean[i] = sums[i]/numResults;
+    noise += sqrt(sumSquares[i]/numResults - mean[i] * mean[i])/4.0;
+  }
+}
+
+// Run a number of calibrations, and return the RMS error of the offsets and the average of the noise that the calibrations measured
+static void measureCalibrations(bool independent, const double mean[4], unsigned int runs, double& offsetError, double& noise)
+{
+  double sumSquares = 0.0;
+  noise = 0.0;
+  for (unsigned int r = 0; r < runs; ++r)
+  {
+    if (independent)
+    {
+      startCalibration();
+    }
+    else
+    {
+      calibrator.start(CalibrationWindowsShift);        // consecutive outputs, as the sketch used before
+    }
+    while (calibrator.isCalibrating())
+    {
+      runLoop();
+    }
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+      const double d = calibrator.getOffset(i) - mean[i];
+      sumSquares += d * d;
+    }
+    noise += (double)calibrator.getNoise()/runs;
+  }
+  offsetError = sqrt(sumSquares/(4.0 * runs));
+}
+
+// Compare calibrations that average consecutive filter outputs with ones that average independent outputs, in each filter mode.
+// Averaging 2^CalibrationWindowsShift independent outputs should divide the noise on the offsets by the square root of that, and the noise
+// the calibration measures should be the noise on the filter outputs.
+static bool testCalibration()
+{
+  const unsigned int runs = 32;
+  const double idealGain = sqrt((double)(1u << CalibrationWindowsShift));
+  targetAmplitude = 0.0;
+  bool ok = true;
+  for (uint8_t m = 0; m < NumFilterModes; ++m)
+  {
+    filter.setMode((FilterMode)m);
+    filter.setBlocksShift(2);
+    runTicks(16u * 8u * coilCyclesPerBlock);          // so that no output includes a block from before the target went away
+    double mean[4], outputNoise, consecutiveError, consecutiveNoise, independentError, independentNoise;
+    measureOutputs(400, mean, outputNoise);
+    measureCalibrations(false, mean, runs, consecutiveError, consecutiveNoise);
+    measureCalibrations(true, mean, runs, independentError, independentNoise);
+    const bool modeOk = independentError <= 1.5 * outputNoise/idealGain && fabs(independentNoise - outputNoise) <= 0.25 * outputNoise;
+    printf("Calibration with %-11s filter: output noise %5.1f, offset error %5.1f (noise measured %5.1f) from consecutive outputs, "
+           "%5.1f (noise measured %5.1f) from independent outputs, ideal %5.1f %s\n",
+           WindowFilter::modeName((FilterMode)m), outputNoise, consecutiveError, consecutiveNoise, independentError, independentNoise,
+           outputNoise/idealGain, modeOk ? "ok" : "FAILED");
+    ok = ok && modeOk;
+  }
+  filter.setMode(FilterBoxcar);
+  filter.setBlocksShift(WindowFilter::MaxBlocksShift);
+  calibrator.clear();
+  return ok;
+}
+
+// Check that the tone's duty cycle is the nearest to volume/16 of the period that timer 2 can give, and never zero unless the volume is zero.
+// This uses its own AudioEngine, so that the sketch's ISR doesn't change the tone under it.
+static bool testAudioDuty()
+{
+  AudioEngine engine;
+  unsigned int failures = 0;
+  for (uint16_t freq = AudioEngine::MinFrequency; freq <= AudioEngine::MaxFrequency; ++freq)
+  {
+    for (uint8_t vol = 0; vol <= AudioEngine::MaxVolume; ++vol)
+    {
+      engine.setTone(0, 0);
+      engine.update();                  // stop the tone, so that the next one starts at its target pitch instead of sliding
+      engine.setTone(freq, vol);
+      engine.update();
+      const uint8_t top = OCR2A;
+      bool ok;
+      if (vol == 0)
+      {
+        ok = (OCR2B > top);
+      }
+      else
+      {
+        const int high = top - OCR2B;   // OC2B is high from OCR2B to TOP
+        const double ideal = top * vol/16.0;
+        ok = high >= 1 && (fabs(high - ideal) <= 0.5 || (high == 1 && ideal < 0.5));
+      }
+      if (!ok && failures++ < 5)
+      {
+        printf("Tone %uHz volume %u: OCR2A %u OCR2B %u FAILED\n", freq, vol, top, OCR2B);
+      }
+    }
+  }
+  printf("Tone duty cycle at every pitch and volume %s\n", (failures == 0) ? "ok" : "FAILED");
+  return failures == 0;
+}
+
+// Measure the host cost of the ISR alone, with loop() taking every block as soon as it is ready
+static double measureIsrNanos()
+{
+  const uint32_t calls = 2000000;
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < calls; ++i)
+  {
+    runIsr();
+    blocksRead = blocksWritten;
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count()/calls;
+}
+
+int main(int argc, char **argv)
+{
+  double seconds = 5.0;
+  int opt;
+  while ((opt = getopt(argc, argv, "s:n:l:r:d:b:")) != -1)
+  {
+    switch (opt)
+    {
+    case 's': seconds = atof(optarg); break;
+    case 'n': noiseAmplitude = atof(optarg); break;
+    case 'l': cost.loopClocks = atol(optarg); break;
+    case 'r': cost.resultClocks = atol(optarg); break;
+    case 'd': cost.displayClocks = atol(optarg); break;
+    case 'b': cost.byteClocks = atol(optarg); break;
+    default:
+      fprintf(stderr, "Usage: %s [-s seconds] [-n noise] [-l loopClocks] [-r resultClocks] [-d displayClocks] [-b byteClocks]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  // setup() waits for the first block, so the ISR must have produced one before we call it
+  for (uint16_t i = 0; i < 8u * coilCyclesPerBlock; ++i)
+  {
+    runIsr();
+  }
+  setup();
+  lcd->setTimeSource(simTimeSource, 16);
+  printf("ADC mode %d, coil TOP %u (%.0f ticks/s), %u coil cycles per block, phaseAdjust %d\n",
+         ADC_MODE, coilTop, ticksPerSecond(), coilCyclesPerBlock, phaseAdjust);
+
+  bool ok = true;
+  for (const Scenario& s : scenarios)
+  {
+    ok = runScenario(s) && ok;
+  }
+
+  const uint8_t defaultTop = coilTop;
+  ok = testRetune(MaxCoilTop) && ok;
+  ok = testSettings() && ok;
+  ok = testRetune(defaultTop) && ok;
+  ok = testCalibration() && ok;
+
+  // Throughput with a target present, so that the display and the tone are busy
+  targetAmplitude = 20.0;
+  const uint32_t startSamples = sampleNumber;
+  const uint16_t startDropped = blocksDropped;
+  const uint16_t startMisses = misses;
+  uint32_t blocks = 0;
+  const uint32_t runSamples = (uint32_t)(seconds * ticksPerSecond());
+  while (sampleNumber - startSamples < runSamples)
+  {
+    const uint16_t before = blocksProcessed;
+    runTicks(1000);
+    blocks += (uint16_t)(blocksProcessed - before);
+  }
+  const double simSeconds = (sampleNumber - startSamples)/ticksPerSecond();
+  const uint16_t dropped = blocksDropped - startDropped;
+  const uint16_t missed = misses - startMisses;
+  const double isrNanos = measureIsrNanos();
+  printf("Simulated %.1fs: %.0f samples/s processed, %u blocks, %u dropped, %u ISR misses\n",
+         simSeconds, blocks * 8.0 * coilCyclesPerBlock/simSeconds, blocks, dropped, missed);
+  printf("ISR: %.1fns per call on this host\n", isrNanos);
+  if (dropped != 0 || missed != 0)
+  {
+    ok = false;
+  }
+
+  // Make loop() too slow to keep up, to check that the ISR counts the blocks it drops instead of overwriting unread ones
+  const uint16_t droppedBefore = blocksDropped;
+  const uint32_t savedResultClocks = cost.resultClocks;
+  cost.resultClocks = 20u * blockMicros * (F_CPU/1000000u);
+  filter.setMode(FilterSliding);        // a result for every block
+  runTicks((uint32_t)(ticksPerSecond()/2));
+  cost.resultClocks = savedResultClocks;
+  const uint16_t slowDropped = blocksDropped - droppedBefore;
+  printf("Overloaded loop(): %u blocks dropped %s\n", slowDropped, (slowDropped != 0) ? "ok" : "FAILED");
+  if (slowDropped == 0)
+  {
+    ok = false;
+  }
+
+  ok = testAudioDuty() && ok;
+
+  printf("%s\n", ok ? "PASSED" : "FAILED");
+  return ok ? 0 : 1;
+}
+
+// End
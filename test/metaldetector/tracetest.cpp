@@ -0,0 +1,174 @@
+// Replay of telemetry traces through the metal detector sketch's classification.
+// Each trace is a CSV file in the format that MetalDetector/extras/decodetelemetry.py writes, with two more columns: the detection threshold,
+// and the name of the class we expect. Lines starting with '#' are comments. For each row the test loads the calibration offsets and
+// the filter outputs, calls the sketch's processResult(), and checks the target class. For rows with a class that has a phase, it also
+// checks the amplitude and the phase average against the ones in the trace.
+//
+// Usage: tracetest trace.csv...
+// To add a trace captured from a detector, decode it with decodetelemetry.py, keep the rows of interest, and add the two columns.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "../../MetalDetector/MetalDetector.ino"
+
+static const char * const requiredColumns[] =
+{
+  "coilTop", "average0", "average1", "average2", "average3", "offset0", "offset1", "offset2", "offset3",
+  "ampAverage", "phaseAverage", "threshold", "expected"
+};
+static const unsigned int numRequiredColumns = sizeof(requiredColumns)/sizeof(requiredColumns[0]);
+static const unsigned int MaxColumns = 32;
+
+// Split a CSV line in place into fields, returning the number of fields
+static unsigned int splitLine(char *line, char *fields[MaxColumns])
+{
+  unsigned int n = 0;
+  line[strcspn(line, "\r\n")] = 0;
+  for (char *p = line; n < MaxColumns; )
+  {
+    fields[n++] = p;
+    p = strchr(p, ',');
+    if (p == nullptr)
+    {
+      break;
+    }
+    *p++ = 0;
+  }
+  return n;
+}
+
+// Difference between two phases in tenths of a degree, wrapped into -1800 to +1799
+static int phaseError(int a, int b)
+{
+  int d = (a - b) % 3600;
+  if (d < -1800) d += 3600;
+  if (d >= 1800) d -= 3600;
+  return d;
+}
+
+// Replay one row, returning true if the sketch gives the expected results
+static bool replayRow(char * const fields[], const unsigned int columns[], unsigned int lineNumber)
+{
+  coilTop = (uint8_t)atoi(fields[columns[0]]);
+  updateCoilTimings();
+
+  // Load the offsets with a calibration of a single result
+  int16_t offsets[4];
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    averages[i] = (int16_t)atoi(fields[columns[1 + i]]);
+    offsets[i] = (int16_t)atoi(fields[columns[5 + i]]);
+  }
+  calibrator.clear();
+  calibrator.start(0);
+  calibrator.addResult(offsets);
+
+  threshold = (uint16_t)atoi(fields[columns[11]]);
+  processResult();
+
+  const char * const expected = fields[columns[12]];
+  bool ok = strcmp(Classifier::className(targetClass), expected) == 0 && phaseAverage >= -1800 && phaseAverage < 1800;
+  if (targetClass != TargetNone && targetClass != TargetOverload)
+  {
+    const double expectedAmp = atof(fields[columns[9]]);
+    const int expectedPhase = (int)lround(atof(fields[columns[10]]) * 10.0);
+    ok = ok && abs(phaseError(phaseAverage, expectedPhase)) <= 10 && ampAverage >= expectedAmp * 0.99 && ampAverage <= expectedAmp * 1.01;
+  }
+  if (!ok)
+  {
+    printf("FAILED: line %u: amp %u phase %d class %s, expected amp %s phase %s class %s\n", lineNumber, ampAverage, phaseAverage,
+           Classifier::className(targetClass), fields[columns[9]], fields[columns[10]], expected);
+  }
+  return ok;
+}
+
+// Replay a trace file, returning the number of rows that failed, or -1 if the file can't be read
+static int replayTrace(const char *fileName)
+{
+  FILE *f = fopen(fileName, "r");
+  if (f == nullptr)
+  {
+    printf("FAILED: can't open %s\n", fileName);
+    return -1;
+  }
+
+  char line[1024];
+  char *fields[MaxColumns];
+  unsigned int columns[numRequiredColumns];
+  bool haveHeader = false;
+  unsigned int lineNumber = 0, rows = 0;
+  int failures = 0;
+  while (fgets(line, sizeof(line), f) != nullptr)
+  {
+    ++lineNumber;
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+    {
+      continue;
+    }
+    const unsigned int n = splitLine(line, fields);
+    if (!haveHeader)
+    {
+      for (unsigned int c = 0; c < numRequiredColumns; ++c)
+      {
+        columns[c] = MaxColumns;
+        for (unsigned int i = 0; i < n; ++i)
+        {
+          if (strcmp(fields[i], requiredColumns[c]) == 0)
+          {
+            columns[c] = i;
+          }
+        }
+        if (columns[c] == MaxColumns)
+        {
+          printf("FAILED: %s has no %s column\n", fileName, requiredColumns[c]);
+          fclose(f);
+          return -1;
+        }
+      }
+      haveHeader = true;
+    }
+    else
+    {
+      const unsigned int *maxColumn = std::max_element(columns, columns + numRequiredColumns);
+      if (n <= *maxColumn)
+      {
+        printf("FAILED: line %u: too few columns\n", lineNumber);
+        ++failures;
+      }
+      else if (!replayRow(fields, columns, lineNumber))
+      {
+        ++failures;
+      }
+      ++rows;
+    }
+  }
+  fclose(f);
+  printf("%s: %u results, %d failed\n", fileName, rows, failures);
+  return failures;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "Usage: %s trace.csv...\n", argv[0]);
+    return 2;
+  }
+
+  bool ok = true;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (replayTrace(argv[i]) != 0)
+    {
+      ok = false;
+    }
+  }
+  printf("%s\n", ok ? "PASSED" : "FAILED");
+  return ok ? 0 : 1;
+}
+
+// End
@@ -0,0 +1,82 @@
+// Host stand-in for the parts of the Arduino core that the libraries and the metal detector sketch use.
+// Time is virtual: it only advances when the code under test waits for something, or when a test advances it.
+
+#ifndef __Arduino_Included
+#define __Arduino_Included
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/interrupt.h>
+#include "Print.h"
+
+#define F_CPU 16000000UL
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define DEFAULT 1
+#define EXTERNAL 0
+
+// Virtual time in microseconds. Each call to micros() takes 1us, so that code that polls it always makes progress.
+extern uint32_t mockMicros;
+
+inline unsigned long micros() { return mockMicros++; }
+inline unsigned long millis() { return mockMicros/1000u; }
+inline void delayMicroseconds(unsigned int us) { mockMicros += us; }
+inline void delay(unsigned long ms) { mockMicros += ms * 1000u; }
+
+inline void noInterrupts() { cli(); }
+inline void interrupts() { sei(); }
+
+// Digital pins 0-7 are on port D, 8-13 on port B and 14-19 (A0-A5) on port C, as on the ATmega328p.
+// The input registers read all 1s (inputs pulled up, buttons released) unless a test changes them.
+enum { MockPortB = 1, MockPortC = 2, MockPortD = 3, MockNumPorts = 4 };
+extern volatile uint8_t mockPortIn[MockNumPorts];
+extern volatile uint8_t mockPortOut[MockNumPorts];
+extern volatile uint8_t mockPortMode[MockNumPorts];
+extern uint16_t mockAnalogValue;                // what analogRead() returns
+
+#define NOT_A_PORT 0
+#define digitalPinToPort(p) ((p) < 8 ? MockPortD : (p) < 14 ? MockPortB : MockPortC)
+#define digitalPinToBitMask(p) ((uint8_t)(1u << ((p) < 8 ? (p) : (p) < 14 ? (p) - 8 : (p) - 14)))
+#define portInputRegister(port) (&mockPortIn[port])
+#define portOutputRegister(port) (&mockPortOut[port])
+#define portModeRegister(port) (&mockPortMode[port])
+#define digitalPinToPCICR(p) (&PCICR)
+#define digitalPinToPCICRbit(p) ((p) < 8 ? 2 : (p) < 14 ? 0 : 1)
+#define digitalPinToPCMSK(p) ((p) < 8 ? &PCMSK2 : (p) < 14 ? &PCMSK0 : &PCMSK1)
+#define digitalPinToPCMSKbit(p) ((p) < 8 ? (p) : (p) < 14 ? (p) - 8 : (p) - 14)
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int val);
+int digitalRead(int pin);
+inline int analogRead(int) { return mockAnalogValue; }
+inline void analogReference(int) { }
+
+template<class T, class U, class V> T constrain(T x, U lo, V hi) { return (x < lo) ? lo : (x > hi) ? hi : x; }
+
+// Serial port that keeps everything written to it
+class HardwareSerial : public Print
+{
+public:
+  void begin(unsigned long) { }
+  size_t write(uint8_t b) { output.push_back(b); return 1; }
+  using Print::write;
+  int availableForWrite() { return 63; }
+
+  std::vector<uint8_t> output;
+};
+
+extern HardwareSerial Serial;
+
+#endif
+
+// End
@@ -0,0 +1,39 @@
+// Host stand-in for the Arduino EEPROM library. The EEPROM starts erased (all 0xFF), as on a new chip.
+
+#ifndef __EEPROM_Included
+#define __EEPROM_Included
+
+#include <stdint.h>
+#include <string.h>
+
+class EEPROMClass
+{
+public:
+  static const int Size = 1024;
+
+  EEPROMClass() { memset(data, 0xFF, sizeof(data)); }
+
+  uint8_t read(int addr) const { return data[addr]; }
+  void write(int addr, uint8_t val) { data[addr] = val; ++writes; }
+  void update(int addr, uint8_t val) { if (data[addr] != val) { write(addr, val); } }
+
+  template<class T> T& get(int addr, T& t) const { memcpy(&t, data + addr, sizeof(T)); return t; }
+  template<class T> const T& put(int addr, const T& t)
+  {
+    const uint8_t *p = (const uint8_t*)&t;
+    for (size_t i = 0; i < sizeof(T); ++i)
+    {
+      update(addr + i, p[i]);
+    }
+    return t;
+  }
+
+  uint8_t data[Size];
+  unsigned int writes = 0;              // number of bytes actually written, to check that we don't wear the EEPROM needlessly
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
+
+// End
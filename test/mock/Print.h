@@ -0,0 +1,41 @@
+// Host stand-in for the Arduino Print class
+
+#ifndef __Print_Included
+#define __Print_Included
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define DEC 10
+#define HEX 16
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+class Print
+{
+public:
+  virtual ~Print() { }
+  virtual size_t write(uint8_t) = 0;
+  size_t write(const uint8_t *b, size_t n) { for (size_t i = 0; i < n; ++i) { write(b[i]); } return n; }
+  size_t write(const char *s) { return print(s); }
+
+  size_t print(const char *s) { size_t n = 0; while (*s != 0) { n += write((uint8_t)*s++); } return n; }
+  size_t print(const __FlashStringHelper *s) { return print(reinterpret_cast<const char *>(s)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(int v, int base = DEC) { return print((long)v, base); }
+  size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(long v, int base = DEC) { char buf[24]; snprintf(buf, sizeof(buf), (base == HEX) ? "%lX" : "%ld", v); return print(buf); }
+  size_t print(unsigned long v, int base = DEC) { char buf[24]; snprintf(buf, sizeof(buf), (base == HEX) ? "%lX" : "%lu", v); return print(buf); }
+  size_t print(double v, int digits = 2) { char buf[32]; snprintf(buf, sizeof(buf), "%.*f", digits, v); return print(buf); }
+
+  size_t println() { return print("\r\n"); }
+  template<class T> size_t println(T v) { const size_t n = print(v); return n + println(); }
+  template<class T> size_t println(T v, int d) { const size_t n = print(v, d); return n + println(); }
+};
+
+#endif
+
+// End
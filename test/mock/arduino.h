@@ -0,0 +1,4 @@
+// Some of the libraries include the core header by its lower case name
+#include "Arduino.h"
+
+// End
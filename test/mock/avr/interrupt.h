@@ -0,0 +1,16 @@
+// Host stand-in for <avr/interrupt.h>. An ISR is an ordinary function that the test calls to simulate the interrupt.
+
+#ifndef __Interrupt_Included
+#define __Interrupt_Included
+
+#include <avr/io.h>
+
+inline void cli() { SREG &= (uint8_t)~(1u << SREG_I); }
+inline void sei() { SREG |= (1u << SREG_I); }
+
+#define ISR(vector, ...) extern "C" void vector()
+#define ISR_ALIASOF(vector)
+
+#endif
+
+// End
@@ -0,0 +1,115 @@
+// Host stand-in for <avr/io.h> with the ATmega328p registers that the libraries and the metal detector sketch use.
+// Most registers are plain variables that the code under test writes and the test reads, or the other way round.
+// The SPI registers simulate a transfer that takes mockSpiByteMicros of virtual time, and log every byte sent.
+
+#ifndef __Io_Included
+#define __Io_Included
+
+#include <stdint.h>
+#include <vector>
+
+#define MOCK_REG8(name) extern volatile uint8_t name
+#define MOCK_REG16(name) extern volatile uint16_t name
+
+MOCK_REG8(SREG);
+MOCK_REG8(GTCCR);
+MOCK_REG8(PRR);
+
+MOCK_REG8(TCCR0A); MOCK_REG8(TCCR0B); MOCK_REG8(TCNT0); MOCK_REG8(OCR0A); MOCK_REG8(OCR0B); MOCK_REG8(TIMSK0); MOCK_REG8(TIFR0);
+MOCK_REG8(TCCR1A); MOCK_REG8(TCCR1B); MOCK_REG8(TCCR1C); MOCK_REG8(TIMSK1); MOCK_REG8(TIFR1);
+MOCK_REG8(TCNT1H); MOCK_REG8(TCNT1L); MOCK_REG8(OCR1AH); MOCK_REG8(OCR1AL); MOCK_REG8(ICR1H); MOCK_REG8(ICR1L);
+MOCK_REG16(TCNT1); MOCK_REG16(OCR1A); MOCK_REG16(ICR1);
+MOCK_REG8(TCCR2A); MOCK_REG8(TCCR2B); MOCK_REG8(TCNT2); MOCK_REG8(OCR2A); MOCK_REG8(OCR2B); MOCK_REG8(TIMSK2); MOCK_REG8(TIFR2); MOCK_REG8(ASSR);
+MOCK_REG8(ADMUX); MOCK_REG8(ADCSRA); MOCK_REG8(ADCSRB); MOCK_REG8(DIDR0); MOCK_REG8(ADCH); MOCK_REG8(ADCL);
+MOCK_REG16(ADC); MOCK_REG16(ADCW);
+MOCK_REG8(PCICR); MOCK_REG8(PCMSK0); MOCK_REG8(PCMSK1); MOCK_REG8(PCMSK2);
+MOCK_REG8(PINB); MOCK_REG8(PINC); MOCK_REG8(PIND);
+MOCK_REG8(SPCR);
+MOCK_REG16(SP);
+
+// SPI data register. Writing it starts a transfer.
+struct MockSpiByte
+{
+  uint8_t data;
+  uint32_t time;                        // virtual time in microseconds when the byte was written
+};
+
+class MockSpdr
+{
+public:
+  MockSpdr& operator=(uint8_t b);
+  operator uint8_t() const { return 0; }
+};
+
+// SPI status register. SPIF reads as set once the current transfer has finished. Reading it while a transfer is in progress
+// takes 1us of virtual time, so that busy-waiting on it makes progress.
+class MockSpsr
+{
+public:
+  operator uint8_t() const;
+  MockSpsr& operator=(uint8_t b) { bits = b & 0x01; return *this; }
+  uint8_t bits;
+};
+
+extern MockSpdr SPDR;
+extern MockSpsr SPSR;
+extern std::vector<MockSpiByte> mockSpiLog;     // every byte written to SPDR
+extern uint8_t mockSpiByteMicros;               // how long a transfer takes, 8us at the 1MHz SPI clock by default
+
+// Register bits
+#define SREG_I 7
+#define PRSPI 2
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define WGM00 0
+#define WGM01 1
+#define WGM02 3
+#define COM0B1 5
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM11 1
+#define WGM12 3
+#define WGM13 4
+#define COM1A1 7
+#define TOIE1 0
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM20 0
+#define WGM21 1
+#define WGM22 3
+#define COM2B0 4
+#define COM2B1 5
+#define TOIE2 0
+#define OCIE2A 1
+#define TOV2 0
+#define OCF2A 1
+#define TCN2UB 4
+#define TCR2AUB 1
+#define REFS0 6
+#define ADLAR 5
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADTS0 0
+#define ADTS1 1
+#define ADTS2 2
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define SPIE 7
+#define SPE 6
+#define MSTR 4
+#define SPR0 0
+#define SPIF 7
+#define SPI2X 0
+
+#endif
+
+// End
@@ -0,0 +1,24 @@
+// Host stand-in for <avr/pgmspace.h>. Program memory is ordinary memory on the host.
+
+#ifndef __Pgmspace_Included
+#define __Pgmspace_Included
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define memcpy_P memcpy
+
+template<class T> inline T mockReadWord(const T *p) { return *p; }
+inline uint16_t mockReadWord(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_byte_near(p) pgm_read_byte(p)
+#define pgm_read_word(p) mockReadWord(p)
+#define pgm_read_word_near(p) mockReadWord(p)
+#define pgm_read_ptr(p) (*(void * const *)(p))
+
+#endif
+
+// End
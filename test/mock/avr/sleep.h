@@ -0,0 +1,14 @@
+// Host stand-in for <avr/sleep.h>
+
+#ifndef __Sleep_Included
+#define __Sleep_Included
+
+#define SLEEP_MODE_IDLE 0
+inline void set_sleep_mode(int) { }
+inline void sleep_enable() { }
+inline void sleep_disable() { }
+inline void sleep_cpu() { }
+
+#endif
+
+// End
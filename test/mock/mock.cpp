@@ -0,0 +1,90 @@
+// Definitions for the host stand-ins of the Arduino core and the AVR registers
+
+#include "Arduino.h"
+#include "EEPROM.h"
+
+uint32_t mockMicros = 0;
+uint16_t mockAnalogValue = 0;
+volatile uint8_t mockPortIn[MockNumPorts] = { 0xFF, 0xFF, 0xFF, 0xFF };
+volatile uint8_t mockPortOut[MockNumPorts];
+volatile uint8_t mockPortMode[MockNumPorts];
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+
+#define MOCK_DEFINE8(name) volatile uint8_t name
+#define MOCK_DEFINE16(name) volatile uint16_t name
+
+MOCK_DEFINE8(SREG);
+MOCK_DEFINE8(GTCCR);
+MOCK_DEFINE8(PRR);
+MOCK_DEFINE8(TCCR0A); MOCK_DEFINE8(TCCR0B); MOCK_DEFINE8(TCNT0); MOCK_DEFINE8(OCR0A); MOCK_DEFINE8(OCR0B); MOCK_DEFINE8(TIMSK0); MOCK_DEFINE8(TIFR0);
+MOCK_DEFINE8(TCCR1A); MOCK_DEFINE8(TCCR1B); MOCK_DEFINE8(TCCR1C); MOCK_DEFINE8(TIMSK1); MOCK_DEFINE8(TIFR1);
+MOCK_DEFINE8(TCNT1H); MOCK_DEFINE8(TCNT1L); MOCK_DEFINE8(OCR1AH); MOCK_DEFINE8(OCR1AL); MOCK_DEFINE8(ICR1H); MOCK_DEFINE8(ICR1L);
+MOCK_DEFINE16(TCNT1); MOCK_DEFINE16(OCR1A); MOCK_DEFINE16(ICR1);
+MOCK_DEFINE8(TCCR2A); MOCK_DEFINE8(TCCR2B); MOCK_DEFINE8(TCNT2); MOCK_DEFINE8(OCR2A); MOCK_DEFINE8(OCR2B); MOCK_DEFINE8(TIMSK2); MOCK_DEFINE8(TIFR2); MOCK_DEFINE8(ASSR);
+MOCK_DEFINE8(ADMUX); MOCK_DEFINE8(ADCSRA); MOCK_DEFINE8(ADCSRB); MOCK_DEFINE8(DIDR0); MOCK_DEFINE8(ADCH); MOCK_DEFINE8(ADCL);
+MOCK_DEFINE16(ADC); MOCK_DEFINE16(ADCW);
+MOCK_DEFINE8(PCICR); MOCK_DEFINE8(PCMSK0); MOCK_DEFINE8(PCMSK1); MOCK_DEFINE8(PCMSK2);
+MOCK_DEFINE8(PINB); MOCK_DEFINE8(PINC); MOCK_DEFINE8(PIND);
+MOCK_DEFINE8(SPCR);
+MOCK_DEFINE16(SP);
+
+MockSpdr SPDR;
+MockSpsr SPSR;
+std::vector<MockSpiByte> mockSpiLog;
+uint8_t mockSpiByteMicros = 8;
+
+static uint32_t spiDoneTime = 0;        // virtual time when the current SPI transfer finishes
+
+MockSpdr& MockSpdr::operator=(uint8_t b)
+{
+  MockSpiByte sent;
+  sent.data = b;
+  sent.time = mockMicros;
+  mockSpiLog.push_back(sent);
+  spiDoneTime = mockMicros + mockSpiByteMicros;
+  return *this;
+}
+
+MockSpsr::operator uint8_t() const
+{
+  if ((int32_t)(mockMicros - spiDoneTime) >= 0)
+  {
+    return bits | (1u << SPIF);
+  }
+  ++mockMicros;
+  return bits;
+}
+
+void pinMode(int pin, int mode)
+{
+  const uint8_t mask = digitalPinToBitMask(pin);
+  if (mode == OUTPUT)
+  {
+    mockPortMode[digitalPinToPort(pin)] |= mask;
+  }
+  else
+  {
+    mockPortMode[digitalPinToPort(pin)] &= (uint8_t)~mask;
+  }
+}
+
+void digitalWrite(int pin, int val)
+{
+  const uint8_t mask = digitalPinToBitMask(pin);
+  if (val)
+  {
+    mockPortOut[digitalPinToPort(pin)] |= mask;
+  }
+  else
+  {
+    mockPortOut[digitalPinToPort(pin)] &= (uint8_t)~mask;
+  }
+}
+
+int digitalRead(int pin)
+{
+  return (mockPortIn[digitalPinToPort(pin)] & digitalPinToBitMask(pin)) ? HIGH : LOW;
+}
+
+// End
@@ -0,0 +1,3 @@
+// Pin mappings are in Arduino.h in the host build
+
+// End
@@ -0,0 +1,20 @@
+// Host stand-in for <util/crc16.h>
+
+#ifndef __Crc16_Included
+#define __Crc16_Included
+
+#include <stdint.h>
+
+static inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data)
+{
+  crc ^= (uint16_t)data << 8;
+  for (uint8_t i = 0; i < 8; ++i)
+  {
+    crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+#endif
+
+// End
@@ -0,0 +1,295 @@
+// Benchmark of how long the scheduler keeps interrupts disabled.
+// The simulated SREG in SchedulerHal.h calls a hook whenever the interrupt enable bit changes, which we use to time every critical section.
+// With 4, 16 and 64 tasks, we keep the tasks busy being suspended, woken up, notified, ticked and run in a random order, and report the
+// longest and the mean time that each operation kept interrupts disabled. The times are on the host, so only the way they grow with the
+// number of tasks carries over to the target. Both times come from the run with the lowest worst time of several runs, to filter out the
+// host's own interrupts, so that the mean is over the same critical sections as the worst time.
+// Appending to a ready list, suspend() and notify() don't depend on the number of tasks. wakeup(n) does, because it walks the delay list to find
+// where to insert the task, and so does loop() when body() asks to sleep. A tick takes longer with more tasks because more of them are due.
+// It also reports how many task switches per second loop() manages on the host, with tasks that yield and with tasks that sleep.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "Scheduler.h"
+#include "SchedulerHal.h"
+
+typedef std::chrono::steady_clock Clock;
+
+enum Operation
+{
+  opNone = -1,
+  opEmpty = 0,              // an empty critical section, i.e. the cost of the measurement itself
+  opWakeupReady,            // wakeup(0) of a suspended task
+  opWakeupDelay,            // wakeup(n) of a suspended task, n > 0
+  opSuspend,                // suspend() of a task that is ready or on the delay list
+  opNotify,                 // notify() of a task that is ready or on the delay list
+  opSetPriority,
+  opTick,
+  opLoop,                   // Task::loop() running one task, whose body() asks to sleep
+  numOperations
+};
+
+static const char * const operationNames[numOperations] =
+{
+  "empty cli/sei", "wakeup(0)", "wakeup(n)", "suspend", "notify", "setPriority", "tick", "loop"
+};
+
+struct Window
+{
+  double worst;
+  double total;
+  unsigned long count;
+};
+
+static Window windows[numOperations];
+static Operation currentOperation = opNone;
+static Clock::time_point disabledAt;
+static bool disabled = false;
+static unsigned long errors = 0;
+
+static void interruptHook(bool enabled)
+{
+  const Clock::time_point now = Clock::now();
+  if (!enabled)
+  {
+    disabledAt = now;
+    disabled = true;
+  }
+  else
+  {
+    disabled = false;
+    if (currentOperation != opNone)
+    {
+      Window& w = windows[currentOperation];
+      const double ns = std::chrono::duration<double, std::nano>(now - disabledAt).count();
+      if (ns > w.worst)
+      {
+        w.worst = ns;
+      }
+      w.total += ns;
+      ++w.count;
+    }
+  }
+}
+
+class BenchTask : public Task
+{
+public:
+  BenchTask(uint8_t pri) : Task(pri) { }
+  void start(int sleepTime) { wakeup(sleepTime); }
+
+protected:
+  /*override*/ int body() { return rand() % 100; }
+};
+
+// A task for measuring switches per second, which yields or sleeps for a fixed time
+class SwitchTask : public Task
+{
+public:
+  SwitchTask(uint8_t pri, int s) : Task(pri), sleepTime(s) { }
+  void start() { wakeup(sleepTime); }
+  static unsigned long switches;
+
+protected:
+  /*override*/ int body()
+  {
+    ++switches;
+    return sleepTime;
+  }
+
+private:
+  const int sleepTime;
+};
+
+unsigned long SwitchTask::switches = 0;
+
+// Return the number of task switches per second on the host, calling Task::tick() whenever no task is ready
+static double switchesPerSecond(SwitchTask **tasks, unsigned int numTasks)
+{
+  static const unsigned long numSwitches = 2000000;
+  for (unsigned int i = 0; i < numTasks; ++i)
+  {
+    tasks[i]->start();
+  }
+  SwitchTask::switches = 0;
+  const Clock::time_point start = Clock::now();
+  while (SwitchTask::switches < numSwitches)
+  {
+    const unsigned long before = SwitchTask::switches;
+    Task::loop();
+    if (SwitchTask::switches == before)
+    {
+      cli();
+      Task::tick();
+      sei();
+    }
+  }
+  const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  for (unsigned int i = 0; i < numTasks; ++i)
+  {
+    tasks[i]->suspend();
+  }
+  return numSwitches/seconds;
+}
+
+static void run(Operation op, void (*f)(BenchTask *t, int arg), BenchTask *t, int arg)
+{
+  currentOperation = op;
+  f(t, arg);
+  currentOperation = opNone;
+  if (disabled || (SREG & (1u << SREG_I)) == 0)
+  {
+    ++errors;
+  }
+}
+
+// Keep the tasks busy in a random order, with every task either ready or on the delay list between operations
+static void exercise(BenchTask **tasks, unsigned int numTasks, unsigned int iterations)
+{
+  for (unsigned int i = 0; i < numTasks; ++i)
+  {
+    tasks[i]->start((i & 1) ? 1 + rand() % 100 : 0);
+  }
+
+  for (unsigned int i = 0; i < iterations; ++i)
+  {
+    BenchTask * const t = tasks[rand() % numTasks];
+    switch (rand() % 6)
+    {
+    case 0:
+      run(opEmpty, [](BenchTask *, int) { cli(); sei(); }, t, 0);
+      break;
+
+    case 1:
+      run(opSuspend, [](BenchTask *t, int) { t->suspend(); }, t, 0);
+      {
+        const int sleepTime = rand() % 100;
+        run((sleepTime == 0) ? opWakeupReady : opWakeupDelay, [](BenchTask *t, int s) { t->start(s); }, t, sleepTime);
+      }
+      break;
+
+    case 2:
+      if (rand() & 1)
+      {
+        run(opNotify, [](BenchTask *t, int) { t->notify(); }, t, 0);
+      }
+      else
+      {
+        run(opSetPriority, [](BenchTask *t, int) { t->setPriority((t->getPriority() + 1) % Task::numPriorities); }, t, 0);
+      }
+      break;
+
+    case 3:
+    case 4:
+      run(opTick, [](BenchTask *, int) { cli(); Task::tick(); sei(); }, t, 0);     // the tick ISR runs with interrupts disabled
+      break;
+
+    case 5:
+      run(opLoop, [](BenchTask *, int) { Task::loop(); }, t, 0);
+      break;
+    }
+  }
+
+  for (unsigned int i = 0; i < numTasks; ++i)
+  {
+    tasks[i]->suspend();
+  }
+}
+
+int main()
+{
+  static const unsigned int taskCounts[] = { 4, 16, 64 };
+  static const unsigned int numCounts = sizeof(taskCounts)/sizeof(taskCounts[0]);
+  static const unsigned int runs = 25;
+  static const unsigned int iterations = 10000;
+  Window best[numCounts][numOperations];
+
+  BenchTask *tasks[64];
+  for (unsigned int i = 0; i < 64; ++i)
+  {
+    tasks[i] = new BenchTask(i % Task::numPriorities);
+  }
+
+  halHostInterruptHook = interruptHook;
+  srand(1);
+  for (unsigned int c = 0; c < numCounts; ++c)
+  {
+    const unsigned int numTasks = taskCounts[c];
+    for (unsigned int op = 0; op < numOperations; ++op)
+    {
+      best[c][op].worst = 1e30;
+      best[c][op].total = 0.0;
+      best[c][op].count = 0;
+    }
+    for (unsigned int r = 0; r < runs; ++r)
+    {
+      for (unsigned int op = 0; op < numOperations; ++op)
+      {
+        windows[op].worst = 0.0;
+        windows[op].total = 0.0;
+        windows[op].count = 0;
+      }
+      exercise(tasks, numTasks, iterations);
+      for (unsigned int op = 0; op < numOperations; ++op)
+      {
+        if (windows[op].count != 0 && windows[op].worst < best[c][op].worst)
+        {
+          best[c][op] = windows[op];
+        }
+      }
+    }
+  }
+  halHostInterruptHook = 0;
+
+  printf("Time with interrupts disabled on the host, worst (mean) in ns, from the run with the lowest worst time of %u\n", runs);
+  printf("%-20s", "Operation");
+  for (unsigned int c = 0; c < numCounts; ++c)
+  {
+    printf("%10u tasks    ", taskCounts[c]);
+  }
+  printf("\n");
+  for (unsigned int op = 0; op < numOperations; ++op)
+  {
+    printf("%-20s", operationNames[op]);
+    for (unsigned int c = 0; c < numCounts; ++c)
+    {
+      const Window& w = best[c][op];
+      if (w.count == 0)
+      {
+        ++errors;                     // every operation should have happened with every number of tasks
+        printf("%20s", "-");
+      }
+      else
+      {
+        printf("%10.0f (%6.1f) ", w.worst, w.total/w.count);
+      }
+    }
+    printf("\n");
+  }
+
+  printf("\nTask switches per second on the host\n%-20s", "Tasks");
+  for (unsigned int c = 0; c < numCounts; ++c)
+  {
+    printf("%10u tasks    ", taskCounts[c]);
+  }
+  for (unsigned int sleeping = 0; sleeping < 2; ++sleeping)
+  {
+    printf("\n%-20s", (sleeping) ? "sleep 1 to 8 ticks" : "yield");
+    for (unsigned int c = 0; c < numCounts; ++c)
+    {
+      SwitchTask *switchTasks[64];
+      for (unsigned int i = 0; i < taskCounts[c]; ++i)
+      {
+        switchTasks[i] = new SwitchTask(i % Task::numPriorities, (sleeping) ? 1 + i % 8 : 0);
+      }
+      printf("%20.0f", switchesPerSecond(switchTasks, taskCounts[c]));
+    }
+  }
+  printf("\n");
+
+  printf("%s\n", (errors == 0) ? "PASSED" : "FAILED");
+  return (errors == 0) ? 0 : 1;
+}
+
+// End
@@ -0,0 +1,692 @@
+// Tests of the scheduler, using its host build.
+// Built with TASK_PROFILING and SCHEDULER_LATENCY_STATS set, with and without SCHEDULER_TICKLESS. Time is virtual: the harness advances the
+// simulated timer count one count at a time and calls Task::tick() when the timer would interrupt, i.e. when it overflows, or in tickless
+// mode when it reaches the compare value.
+// The stress test runs thousands of random wakeups, suspends, notifies, priority changes and runs of tasks, some of them from a simulated ISR
+// or from inside body(), against a model of what the scheduler should do. After every step it checks the delay list wake times, the ready
+// lists, their tails and the ready mask against the model, and each time a task runs it checks that it was the one that should run.
+// PeriodicTask is tested for drift, missed releases, and releases after it is suspended or notified early.
+// The stack measurement is tested against an array that stands for the free RAM, which the tasks write to as if their stack frames were in it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Scheduler.h"
+#include "SchedulerHal.h"
+
+static unsigned int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+  if (!ok)
+  {
+    printf("FAILED: %s\n", what);
+    ++failures;
+  }
+}
+
+#if SCHEDULER_TICKLESS
+static const unsigned int countsPerTick = 16;        // timer 2 runs from a prescaler of 1024
+#else
+static const unsigned int countsPerTick = 256;       // timer 2 overflows once per tick
+#endif
+
+static unsigned long totalCounts = 0;                // virtual time in timer counts since Task::init()
+static bool tickPending = false;
+static void (*afterTick)() = 0;                      // called after each tick interrupt
+static void (*otherIsr)() = 0;                       // another ISR, which the harness calls at random times
+static unsigned int otherIsrChance = 0;              // the chance of calling it at each timer count is 1 in this
+
+// Advance virtual time by a number of timer counts, servicing the tick interrupt when it happens if interrupts are enabled
+static void advance(unsigned long counts)
+{
+  for (unsigned long i = 0; i < counts; ++i)
+  {
+    ++totalCounts;
+    halHostTimerCount = halHostTimerCount + 1;
+#if SCHEDULER_TICKLESS
+    if (halHostTimerCount == halHostTimerCompare)
+    {
+      tickPending = true;
+    }
+#else
+    if (halHostTimerCount == 0)
+    {
+      tickPending = halHostOverflowPending = true;
+    }
+#endif
+    if ((SREG & (1u << SREG_I)) != 0)
+    {
+      if (tickPending)
+      {
+        tickPending = halHostOverflowPending = false;
+        cli();
+        Task::tick();
+        sei();
+        if (afterTick != 0)
+        {
+          afterTick();
+        }
+      }
+      if (otherIsr != 0 && rand() % otherIsrChance == 0)
+      {
+        cli();
+        otherIsr();
+        sei();
+      }
+    }
+  }
+}
+
+static void ticks(unsigned int n)
+{
+  advance(n * (unsigned long)countsPerTick);
+}
+
+class TestTask : public Task
+{
+public:
+  TestTask(uint8_t pri = 0) : Task(pri), stackDepth(0), runTicks(0), runs(0) { }
+  void start(int sleepTime) { wakeup(sleepTime); }
+
+  uint16_t stackDepth;                      // how many bytes of stack body() uses
+  uint16_t runTicks;                        // how many ticks body() takes
+  unsigned int runs;
+
+protected:
+  /*override*/ int body()
+  {
+    ++runs;
+    uint8_t * const top = halHostStackPointer;
+    for (uint16_t i = 0; i < stackDepth; ++i)
+    {
+      if (i % 7 != 3 || i + 1 == stackDepth)
+      {
+        top[-1 - (int)i] = 0;               // leave some bytes alone, like a local array that isn't filled in
+      }
+    }
+    ticks(runTicks);
+    return -1;
+  }
+};
+
+// Reference model of the scheduler, and the checks of the scheduler's lists against it
+
+static const unsigned int numStressTasks = 16;
+
+struct TaskModel
+{
+  enum State { suspended, ready, delaying, running } state;
+  uint8_t priority;
+  bool notified;
+  uint16_t wakeAt;                          // the tick count at which a delaying task is due
+  unsigned long delayOrder;                 // when a delaying task was put on the delay list, to order tasks due at the same tick
+  unsigned long readyOrder;                 // when a ready task was put on its ready list
+};
+
+static TaskModel model[numStressTasks];
+static unsigned long orderCount = 0;
+static unsigned long taskRuns = 0;
+static unsigned long isrNotifies = 0;
+static int expectedToRun = -1;              // the task that loop() should run next, or -1 if none should
+
+class StressTask;
+static StressTask *stressTasks[numStressTasks];
+
+static void modelReady(unsigned int i)
+{
+  model[i].state = TaskModel::ready;
+  model[i].readyOrder = ++orderCount;
+}
+
+static void modelDelay(unsigned int i, int sleepTime)
+{
+  model[i].state = TaskModel::delaying;
+  model[i].wakeAt = Task::getTickCount() + sleepTime;
+  model[i].delayOrder = ++orderCount;
+}
+
+static void modelNotify(unsigned int i)
+{
+  switch (model[i].state)
+  {
+  case TaskModel::suspended:
+  case TaskModel::delaying:
+    modelReady(i);
+    break;
+  case TaskModel::ready:
+    break;
+  case TaskModel::running:
+    model[i].notified = true;
+    break;
+  }
+}
+
+class TaskChecker
+{
+public:
+  static unsigned int indexOf(const Task *t);
+  static bool isReady(unsigned int i);
+  static uint16_t tickCount() { return Task::tickCount; }
+  static void checkLists();
+  static void checkNotLate();
+  static void expire();
+};
+
+class StressTask : public Task
+{
+public:
+  StressTask(unsigned int i, uint8_t pri) : Task(pri), index(i) { }
+  void start(int sleepTime) { wakeup(sleepTime); }
+  const unsigned int index;
+
+protected:
+  /*override*/ int body();
+};
+
+unsigned int TaskChecker::indexOf(const Task *t)
+{
+  return static_cast<const StressTask *>(t)->index;
+}
+
+bool TaskChecker::isReady(unsigned int i)
+{
+  return stressTasks[i]->state == Task::ready;
+}
+
+// Check the ready lists and the delay list against the model
+void TaskChecker::checkLists()
+{
+  bool listed[numStressTasks] = { false };
+  uint8_t mask = 0;
+  for (uint8_t pri = 0; pri < Task::numPriorities; ++pri)
+  {
+    const Task *prev = 0;
+    unsigned long lastOrder = 0;
+    unsigned int count = 0;
+    for (const Task *t = Task::rlr[pri]; t != 0 && count <= numStressTasks; t = t->next, ++count)
+    {
+      const unsigned int i = indexOf(t);
+      check(t->prev == prev, "ready list back link");
+      check(t->state == Task::ready && t->priority == pri, "state and priority of a task on a ready list");
+      check(model[i].state == TaskModel::ready && model[i].priority == pri, "task on a ready list is ready in the model");
+      check(model[i].readyOrder > lastOrder, "ready list is in the order the tasks became ready");
+      check(!listed[i], "task on only one list");
+      listed[i] = true;
+      lastOrder = model[i].readyOrder;
+      prev = t;
+    }
+    check(count <= numStressTasks, "ready list ends");
+    check(Task::rlt[pri] == prev, "ready list tail");
+    if (Task::rlr[pri] != 0)
+    {
+      mask |= (1u << pri);
+    }
+  }
+  check(Task::readyMask == mask, "ready mask matches the ready lists");
+
+  const Task *prev = 0;
+  uint16_t wakeAt = Task::tickCount;
+  unsigned int count = 0;
+  for (const Task *t = Task::dlr; t != 0 && count <= numStressTasks; t = t->next, ++count)
+  {
+    const unsigned int i = indexOf(t);
+    check(t->prev == prev, "delay list back link");
+    check(t->state == Task::delaying, "state of a task on the delay list");
+    check((t == Task::dlr) ? t->ticksToWakeup > 0 : t->ticksToWakeup >= 0, "delay list tick deltas");
+    wakeAt += t->ticksToWakeup;
+    check(model[i].state == TaskModel::delaying && model[i].wakeAt == wakeAt, "delay list wake time matches the model");
+    check(!listed[i], "task on only one list");
+    listed[i] = true;
+    prev = t;
+  }
+  check(count <= numStressTasks, "delay list ends");
+
+  for (unsigned int i = 0; i < numStressTasks; ++i)
+  {
+    if (!listed[i])
+    {
+      const Task *t = stressTasks[i];
+      const bool running = (model[i].state == TaskModel::running);
+      check(model[i].state == TaskModel::suspended || running, "task on no list is suspended or running in the model");
+      check(t->state == (running ? Task::running : Task::suspended), "state of a task on no list");
+      check((Task::current == t) == running, "current task");
+    }
+  }
+}
+
+// Check that no task is still on the delay list after it was due, allowing for the tickless mode deadline being up to 2 counts late
+void TaskChecker::checkNotLate()
+{
+  const uint16_t now = (totalCounts - ((SCHEDULER_TICKLESS) ? 2 : 0))/countsPerTick;
+  for (unsigned int i = 0; i < numStressTasks; ++i)
+  {
+    if (model[i].state == TaskModel::delaying)
+    {
+      check((int16_t)(model[i].wakeAt - now) > 0, "task made ready when it is due");
+    }
+  }
+}
+
+// Tasks that the model has delaying and that the scheduler has made ready have been moved from the delay list. They should have been added to
+// the ready lists in the order they were on the delay list, after any tasks that were already ready.
+void TaskChecker::expire()
+{
+  for (;;)
+  {
+    int first = -1;
+    for (unsigned int i = 0; i < numStressTasks; ++i)
+    {
+      if (model[i].state == TaskModel::delaying && isReady(i))
+      {
+        if (first < 0 || (int16_t)(model[i].wakeAt - model[first].wakeAt) < 0
+            || (model[i].wakeAt == model[first].wakeAt && model[i].delayOrder < model[first].delayOrder))
+        {
+          first = i;
+        }
+      }
+    }
+    if (first < 0)
+    {
+      break;
+    }
+    check((int16_t)(model[first].wakeAt - Task::tickCount) <= 0, "task not made ready before it is due");
+    modelReady(first);
+  }
+}
+
+static void afterStressTick()
+{
+  TaskChecker::expire();
+  TaskChecker::checkNotLate();
+}
+
+static void stressIsr()
+{
+  const unsigned int i = rand() % numStressTasks;
+  stressTasks[i]->notify();
+  modelNotify(i);
+  ++isrNotifies;
+}
+
+// Do something random to a random task, as the main program or another task would. Returns true if it was to run loop().
+static bool randomOperation(bool inBody)
+{
+  const unsigned int i = rand() % numStressTasks;
+  StressTask * const t = stressTasks[i];
+  const unsigned int op = rand() % ((inBody) ? 100 : 110);
+  if (op < 20)
+  {
+    const int sleepTime = (rand() % 4 == 0) ? 0 : 1 + rand() % ((rand() % 8 == 0) ? 300 : 20);
+    if (model[i].state == TaskModel::suspended)
+    {
+      if (sleepTime == 0)
+      {
+        modelReady(i);
+      }
+      else
+      {
+        modelDelay(i, sleepTime);
+      }
+    }
+    t->start(sleepTime);
+  }
+  else if (op < 35)
+  {
+    t->suspend();
+    if (model[i].state != TaskModel::running)
+    {
+      model[i].state = TaskModel::suspended;
+    }
+  }
+  else if (op < 50)
+  {
+    t->notify();
+    modelNotify(i);
+  }
+  else if (op < 60)
+  {
+    const uint8_t pri = rand() % Task::numPriorities;
+    t->setPriority(pri);
+    model[i].priority = pri;
+    if (model[i].state == TaskModel::ready)
+    {
+      model[i].readyOrder = ++orderCount;   // it goes to the back of the ready list for its new priority
+    }
+  }
+  else if (op < 100)
+  {
+    advance(rand() % (2 * countsPerTick));
+  }
+  else
+  {
+    return true;
+  }
+  TaskChecker::expire();
+  TaskChecker::checkLists();
+  TaskChecker::checkNotLate();
+  return false;
+}
+
+// Run loop(), checking that it runs the task that the model says it should
+static void runLoop()
+{
+  expectedToRun = -1;
+  for (unsigned int i = 0; i < numStressTasks; ++i)
+  {
+    if (model[i].state == TaskModel::ready
+        && (expectedToRun < 0 || model[i].priority > model[expectedToRun].priority
+            || (model[i].priority == model[expectedToRun].priority && model[i].readyOrder < model[expectedToRun].readyOrder)))
+    {
+      expectedToRun = i;
+    }
+  }
+  const unsigned long expectedRuns = taskRuns + ((expectedToRun >= 0) ? 1 : 0);
+  Task::loop();
+  check(taskRuns == expectedRuns, "loop() runs a task if one is ready");
+  TaskChecker::expire();
+  TaskChecker::checkLists();
+}
+
+int StressTask::body()
+{
+  ++taskRuns;
+  check((int)index == expectedToRun, "loop() runs the first ready task of the highest priority");
+  check(Task::getCurrent() == this, "getCurrent() in body()");
+  expectedToRun = -1;
+  model[index].state = TaskModel::running;
+  model[index].notified = false;
+
+  const unsigned int ops = rand() % 4;
+  for (unsigned int n = 0; n < ops; ++n)
+  {
+    randomOperation(true);
+  }
+  if (rand() % 1000 == 0)
+  {
+    suspendOthers();
+    for (unsigned int i = 0; i < numStressTasks; ++i)
+    {
+      if (i != index)
+      {
+        model[i].state = TaskModel::suspended;
+      }
+    }
+    TaskChecker::checkLists();
+  }
+
+  const int r = rand() % 8;
+  const int sleepTime = (r == 0) ? -1 : (r == 1) ? 0 : 1 + rand() % 30;
+  if (model[index].notified || sleepTime == 0)
+  {
+    modelReady(index);
+  }
+  else if (sleepTime > 0)
+  {
+    modelDelay(index, sleepTime);
+  }
+  else
+  {
+    model[index].state = TaskModel::suspended;
+  }
+  return sleepTime;
+}
+
+static void testStress()
+{
+  for (unsigned int i = 0; i < numStressTasks; ++i)
+  {
+    stressTasks[i] = new StressTask(i, i % Task::numPriorities);
+    model[i].state = TaskModel::suspended;
+    model[i].priority = i % Task::numPriorities;
+    model[i].notified = false;
+  }
+  afterTick = afterStressTick;
+  otherIsr = stressIsr;
+  otherIsrChance = 3 * countsPerTick;
+
+  const unsigned int failuresBefore = failures;
+  for (unsigned long n = 0; n < 300000 && failures == failuresBefore; ++n)
+  {
+    if (randomOperation(false))
+    {
+      runLoop();
+    }
+    check((SREG & (1u << SREG_I)) != 0, "interrupts enabled between operations");
+  }
+  printf("Stress test: %lu task runs, %lu notifies from the simulated ISR, %lu ticks\n", taskRuns, isrNotifies, totalCounts/countsPerTick);
+
+  afterTick = 0;
+  otherIsr = 0;
+  for (unsigned int i = 0; i < numStressTasks; ++i)
+  {
+    stressTasks[i]->suspend();
+  }
+}
+
+// Run a task once on its own
+static void runOnce(TestTask& t)
+{
+  t.start(0);
+  Task::loop();
+}
+
+static uint16_t maxStackOf(const TestTask& t)
+{
+  Task::TaskStats stats;
+  t.getStats(stats);
+  return stats.maxStack;
+}
+
+static void testStack()
+{
+  static uint8_t ram[1024];
+  memset(ram, 0, sizeof(ram));
+  halHostStackLimit = ram;
+  halHostStackPointer = ram + sizeof(ram);
+  Task::paintStack();
+  check(Task::getUnusedStack() == 1024, "all the free RAM is unused after painting");
+
+  static TestTask a, b, c;
+  a.stackDepth = 100;
+  b.stackDepth = 40;
+  c.stackDepth = 300;
+
+  runOnce(a);
+  check(maxStackOf(a) == 100, "stack used by the first task");
+  check(Task::getUnusedStack() == 924, "unused stack after the first task");
+  runOnce(b);
+  check(maxStackOf(b) == 40, "stack used by a task that uses less than the one before");
+  runOnce(c);
+  check(maxStackOf(c) == 300, "stack used by a task that goes deeper than ever before");
+  check(Task::getUnusedStack() == 724, "unused stack after the deepest task");
+
+  a.resetStats();
+  b.resetStats();
+  runOnce(b);
+  check(maxStackOf(b) == 40, "stack used by a task after a deeper one");
+  runOnce(a);
+  check(maxStackOf(a) == 100, "stack used by the first task again");
+
+  // A task that goes deeper than the lowest point so far, having used less before
+  b.stackDepth = 500;
+  runOnce(b);
+  check(maxStackOf(b) == 500, "stack used by a task that goes deeper again");
+  check(Task::getUnusedStack() == 524, "unused stack after going deeper again");
+  b.stackDepth = 0;
+  b.resetStats();
+  runOnce(b);
+  check(maxStackOf(b) == 0, "stack used by a task that uses none");
+
+  halHostStackLimit = 0;
+  halHostStackPointer = 0;
+}
+
+static void testSaturation()
+{
+  static TestTask t(3);
+  Task::TaskStats stats;
+  Task::LatencyStats latency;
+
+  // A task that waits 10 ticks to run
+  Task::resetLatencyStats();
+  t.start(0);
+  ticks(10);
+  Task::loop();
+  Task::getLatencyStats(3, latency);
+  check(latency.count == 1 && latency.maxLatency == 10 * 256, "latency of 10 ticks");
+  t.getStats(stats);
+  check(stats.lateCount == 1, "task that waited 10 ticks counted as late");
+
+  // A task that waits 300 ticks, which doesn't fit in 16 bits
+  Task::resetLatencyStats();
+  t.resetStats();
+  t.start(0);
+  ticks(300);
+  Task::loop();
+  Task::getLatencyStats(3, latency);
+  check(latency.maxLatency == 0xFFFF && latency.totalLatency == 0xFFFF, "latency of 300 ticks saturates");
+  t.getStats(stats);
+  check(stats.lateCount == 1, "task that waited 300 ticks counted as late");
+
+  // A task that waits 256 ticks, which would wrap round to 0
+  t.resetStats();
+  t.start(0);
+  ticks(256);
+  Task::loop();
+  t.getStats(stats);
+  check(stats.lateCount == 1, "task that waited 256 ticks counted as late");
+
+  // A body() that takes 300 ticks
+  t.resetStats();
+  t.runTicks = 300;
+  runOnce(t);
+  t.getStats(stats);
+  check(stats.maxTime == 0xFFFF && stats.totalTime == 0xFFFF, "run time of 300 ticks saturates");
+  t.runTicks = 2;
+  t.resetStats();
+  runOnce(t);
+  t.getStats(stats);
+  check(stats.maxTime == 2 * 256 && stats.lateCount == 0, "run time of 2 ticks");
+}
+
+class TestPeriodic : public PeriodicTask
+{
+public:
+  TestPeriodic(uint16_t p) : PeriodicTask(p), runTicks(0), suspendNext(false), runs(0), lastRun(0), lastRearm(0) { }
+
+  uint16_t runTicks;                        // how many ticks body() takes
+  bool suspendNext;                         // true to return -1 from body() next time
+  unsigned int runs;
+  uint16_t lastRun;                         // the tick count when body() last started
+  int lastRearm;                            // what rearm() last returned
+
+protected:
+  /*override*/ int body()
+  {
+    ++runs;
+    lastRun = Task::getTickCount();
+    ticks(runTicks);
+    const bool suspend = suspendNext;
+    suspendNext = false;
+    return (suspend) ? -1 : 0;
+  }
+
+  /*override*/ int rearm(int sleepTime)
+  {
+    lastRearm = PeriodicTask::rearm(sleepTime);
+    return lastRearm;
+  }
+};
+
+// Run the scheduler until the task has run once more, and return the tick count when it started
+static uint16_t runNext(TestPeriodic& t)
+{
+  const unsigned int runs = t.runs;
+  for (unsigned long n = 0; t.runs == runs && n < 70000; ++n)
+  {
+    Task::loop();
+    if (t.runs == runs)
+    {
+      ticks(1);
+    }
+  }
+  check(t.runs == runs + 1, "periodic task runs");
+  return t.lastRun;
+}
+
+static void testPeriodic()
+{
+  static TestPeriodic t(10);
+
+  // Releases are every 10 ticks from the start, however long body() takes
+  uint16_t start = Task::getTickCount();
+  t.runTicks = 3;
+  t.start(0);
+  bool steady = true;
+  for (unsigned int i = 0; i < 20; ++i)
+  {
+    steady = steady && runNext(t) == (uint16_t)(start + 10 * i);
+  }
+  check(steady && t.getMissedPeriods() == 0, "periodic task doesn't drift");
+
+  // A run that takes 25 ticks misses one release and the task runs again straight away, then at the next release
+  t.runTicks = 25;
+  start = runNext(t);
+  t.runTicks = 0;
+  check(runNext(t) == (uint16_t)(start + 25) && t.getMissedPeriods() == 1, "periodic task runs again at once after a missed release");
+  check(runNext(t) == (uint16_t)(start + 30), "periodic task runs at the release after a missed one");
+  t.resetMissedPeriods();
+
+  // After the task has been suspended for a long time, notify() starts a new series of releases without any missed periods
+  t.suspendNext = true;
+  runNext(t);
+  check(t.isSuspended(), "periodic task suspended");
+  ticks(1000);
+  t.notify();
+  start = runNext(t);
+  check(start == Task::getTickCount() && runNext(t) == (uint16_t)(start + 10), "releases restart from notify()");
+  check(t.getMissedPeriods() == 0, "no missed periods after notify() of a suspended task");
+
+  // Likewise for start() after being suspended
+  t.suspendNext = true;
+  runNext(t);
+  ticks(777);
+  start = Task::getTickCount();
+  t.start(5);
+  check(runNext(t) == (uint16_t)(start + 5) && runNext(t) == (uint16_t)(start + 15), "releases restart from start()");
+  check(t.getMissedPeriods() == 0, "no missed periods after start() of a suspended task");
+
+  // If notify() makes the task run before a release, it still runs at that release
+  start = runNext(t);
+  ticks(6);
+  t.notify();
+  check(runNext(t) == (uint16_t)(start + 6) && t.lastRearm == 4, "periodic task notified before its release");
+  check(runNext(t) == (uint16_t)(start + 10) && runNext(t) == (uint16_t)(start + 20), "periodic task keeps its releases after notify()");
+  check(t.getMissedPeriods() == 0, "no missed periods after an early notify()");
+
+  // With the longest period, a notify() one tick before the release mustn't ask for a sleep that doesn't fit in a 16-bit int
+  t.setPeriod(32767);
+  start = runNext(t);
+  ticks(32766);
+  t.notify();
+  check(runNext(t) == (uint16_t)(start + 32766) && t.lastRearm == 1, "longest period notified one tick before its release");
+  check(runNext(t) == (uint16_t)(start + 32767) && t.lastRearm == 32767, "longest period");
+
+  t.suspend();
+}
+
+int main()
+{
+  Task::init();
+  testStress();
+  testStack();
+  testSaturation();
+  testPeriodic();
+  check((SREG & (1u << SREG_I)) != 0, "interrupts enabled at the end");
+
+  printf("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+  return (failures == 0) ? 0 : 1;
+}
+
+// End